@@ -4,6 +4,7 @@
     #include <time.h>
     #include <stdio.h>
     #include <stddef.h>
+    #include <stdint.h>
     #include <stdlib.h>
     #include <string.h>
     #include <math.h>
@@ -112,12 +113,43 @@
 
     #define STRING_LENGTH 32
 
+    #define BENCH_ENTRY_MEM        0x1u    /**< time_info carries a memory footprint. */
+    #define BENCH_ENTRY_CHECKED    0x2u    /**< Output was validated against its group. */
+    #define BENCH_ENTRY_MISMATCH   0x4u    /**< Output differed from the group reference. */
+    #define BENCH_ENTRY_TMA        0x8u    /**< time_info carries a top-down breakdown. */
+    #define BENCH_ENTRY_THROTTLED  0x10u   /**< The region overlapped cgroup CPU-quota throttling. */
+
+    /**
+    * @brief Top-down microarchitecture analysis categories (level 1, plus the level-2 backend split).
+    *
+    * Level 1 fractions of issue slots sum to one: retiring + bad speculation +
+    * frontend + backend. The backend is further split into memory and core bound.
+    */
+    typedef enum {
+        BENCH_TMA_RETIRING = 0,   /**< Slots that retired useful work */
+        BENCH_TMA_BAD_SPECULATION,/**< Slots wasted on mispredicted paths */
+        BENCH_TMA_FRONTEND,       /**< Slots the frontend failed to fill */
+        BENCH_TMA_BACKEND,        /**< Slots stalled in the backend */
+        BENCH_TMA_BACKEND_MEMORY, /**< Backend stalls waiting on the memory hierarchy */
+        BENCH_TMA_BACKEND_CORE,   /**< Backend stalls on execution resources */
+        BENCH_TMA_COUNT
+    } bench_tma_class;
+
     /**
     * @brief Benchmark info for a single function.
     */
     typedef struct {
         long long time_us;                            /**< Execution time in microseconds */
         char function_name[MAX_FUNS_NAME_LENGTH];     /**< Human-readable function label */
+        unsigned  flags;                              /**< BENCH_ENTRY_* bits */
+        long long rss_delta;                          /**< RSS change across the region in bytes */
+        long long heap_delta;                         /**< Heap in-use change across the region in bytes */
+        size_t    peak_rss;                           /**< Highest RSS observed inside the region */
+        double    fragmentation;                      /**< Heap (free - top)/arena ratio at region exit */
+        float     tma[BENCH_TMA_COUNT];               /**< Top-down fractions, indexed by bench_tma_class */
+        unsigned  tma_mask;                           /**< Bit (1u << class) set for each measured category */
+        long long throttled_us;                       /**< cgroup throttled time that overlapped the region */
+        unsigned  throttle_periods;                   /**< Quota periods throttled during the region */
     } time_info;
 
     /**
@@ -125,7 +157,7 @@
     */
     typedef struct {
         long long  total_time;                        /**< Total time recorded */
-        long long  start_time;                        /**< Internal use only */
+        long long  start_time;                        /**< Start of the latest region on any thread; timing uses a per-thread copy */
         time_info  timings[MAX_FUNS_TO_BENCH];        /**< Per-function timing info */
         size_t     timing_index;                      /**< Number of functions tracked */
     } benchmark_t;
@@ -143,12 +175,54 @@
     */
     long long get_time_us(void);
 
+    /**
+    * @brief Returns current high-resolution time in nanoseconds.
+    * @return Time in ns.
+    */
+    int64_t get_time_ns(void);
+
+    /**
+    * @brief Seed the library's pseudo-random generator (default seed is fixed).
+    * @param seed Seed value.
+    */
+    void bench_seed(uint64_t seed);
+
+    /**
+    * @brief Next value of the library's pseudo-random generator (splitmix64).
+    * @return 64 random bits.
+    */
+    uint64_t bench_random(void);
+
+    /**
+    * @brief Identifier of the calling thread (kernel TID on Linux).
+    * @return Thread id.
+    */
+    long bench_thread_id(void);
+
+    /**
+    * @brief Marks the start of a timed region (what `START_TIMING()` expands to).
+    */
+    void bench_region_begin(void);
+
     /**
     * @brief Records the time delta since `START_TIMING()` under a named function.
+    *
+    * Each thread keeps its own region start, and entries are claimed atomically,
+    * so several threads may time regions concurrently. Memory capture and
+    * top-down counters only follow the thread that enabled them, and raw
+    * samples assume one recording thread per label.
+    *
     * @param function_name Label to assign to the recorded time.
     */
     void record_timing(const char *function_name);
 
+    /**
+    * @brief Records an already measured duration under a named function.
+    * @param function_name Label to assign to the recorded time.
+    * @param time_us       Duration in microseconds.
+    */
+    void record_timing_us(const char *function_name, long long time_us);
+
     /**
     * @brief Compare two time_info entries (descending).
     * @param a Pointer to first time_info.
@@ -202,12 +276,87 @@
     */
     void print_bench_ranked(void);
 
+    // ─── USDT Probes ─────────────────────────────────────────────────────────────
+
+    /**
+    * @brief Statically defined tracing probes (SystemTap SDT v3 notes).
+    *
+    * Probes live in the `.note.stapsdt` section under provider `bench` and are
+    * visible to `bpftrace -l 'usdt:./app:bench:*'` and `perf probe sdt_bench:*`
+    * without sys/sdt.h. An unattached probe is a single `nop`; arguments that
+    * cost more than a register move (the thread id) are only prepared while a
+    * tracer has bumped the probe's semaphore.
+    *
+    * | Probe          | Arguments                                  |
+    * |----------------|--------------------------------------------|
+    * | `region_begin` | thread id                                  |
+    * | `region_end`   | label (char*), duration (µs), thread id    |
+    * | `log`          | level (0 info, 1 warn, 2 error), file, line |
+    *
+    * Define `BENCH_NO_USDT` to compile the probes out.
+    */
+    #if !defined(BENCH_NO_USDT) && defined(__ELF__) && defined(__GNUC__) && \
+        (defined(__x86_64__) || defined(__aarch64__))
+        #define BENCH_HAVE_USDT 1
+    #endif
+
+    #if defined(BENCH_HAVE_USDT)
+        extern volatile unsigned short bench_sdt_region_begin_semaphore;
+        extern volatile unsigned short bench_sdt_region_end_semaphore;
+        extern volatile unsigned short bench_sdt_log_semaphore;
+
+        #define BENCH_USDT_ENABLED(NAME) \
+            __builtin_expect(bench_sdt_##NAME##_semaphore != 0, 0)
+
+        #define BENCH_USDT_NOTE(NAME, ARGS) \
+            "990: nop\n" \
+            ".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+            ".balign 4\n" \
+            ".4byte 992f-991f,994f-993f,3\n" \
+            "991: .asciz \"stapsdt\"\n" \
+            "992: .balign 4\n" \
+            "993: .8byte 990b\n" \
+            ".8byte _.stapsdt.base\n" \
+            ".8byte bench_sdt_" #NAME "_semaphore\n" \
+            ".asciz \"bench\"\n" \
+            ".asciz \"" #NAME "\"\n" \
+            ".asciz \"" ARGS "\"\n" \
+            "994: .balign 4\n" \
+            ".popsection\n" \
+            ".ifndef _.stapsdt.base\n" \
+            ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+            ".weak _.stapsdt.base\n" \
+            ".hidden _.stapsdt.base\n" \
+            "_.stapsdt.base: .space 1\n" \
+            ".size _.stapsdt.base,1\n" \
+            ".popsection\n" \
+            ".endif\n"
+
+        #define BENCH_USDT1(NAME, A0) \
+            __asm__ __volatile__(BENCH_USDT_NOTE(NAME, "-8@%0") \
+                                 :: "nor"((int64_t)(A0)))
+        #define BENCH_USDT3(NAME, A0, A1, A2) \
+            __asm__ __volatile__(BENCH_USDT_NOTE(NAME, "-8@%0 -8@%1 -8@%2") \
+                                 :: "nor"((int64_t)(A0)), "nor"((int64_t)(A1)), "nor"((int64_t)(A2)))
+    #else
+        #define BENCH_USDT_ENABLED(NAME)        0
+        #define BENCH_USDT1(NAME, A0)           ((void)0)
+        #define BENCH_USDT3(NAME, A0, A1, A2)   ((void)0)
+    #endif
+
+    /**
+    * @brief Fire the `log` probe from a log macro call site.
+    * @param LEVEL 0 for info, 1 for warning, 2 for error.
+    */
+    #define BENCH_USDT_LOG(LEVEL) \
+        BENCH_USDT3(log, (LEVEL), (intptr_t)__FILE__, __LINE__)
+
     // ─── Macros ───────────────────────────────────────────────────────────────────
 
     /**
     * @brief Start timing a block of code.
     */
-    #define START_TIMING()           (get_bench_instance()->start_time = get_time_us())
+    #define START_TIMING()           bench_region_begin()
 
     /**
     * @brief Stop timing and record elapsed duration.
@@ -228,6 +377,7 @@
     */
     #define LOG(...) \
         do { \
+            BENCH_USDT_LOG(0); \
             fprintf(stdout, BRIGHT_CYAN "[INFO] " RESET "[file: %s | line: %d | func: %s] ", __FILE__, __LINE__, __func__); \
             fprintf(stdout, __VA_ARGS__); \
             fprintf(stdout, "\n"); \
@@ -246,6 +396,7 @@
     */
     #define WARN(...) \
         do { \
+            BENCH_USDT_LOG(1); \
             fprintf(stderr, BRIGHT_YELLOW "[WARN] " RESET "[file: %s | line: %d | func: %s] ", __FILE__, __LINE__, __func__); \
             fprintf(stderr, __VA_ARGS__); \
             fprintf(stderr, "\n"); \
@@ -264,6 +415,7 @@
     */
     #define ERROR(...) \
         do { \
+            BENCH_USDT_LOG(2); \
             fprintf(stderr, BRIGHT_RED "[ERROR] " RESET "[file: %s | line: %d | func: %s] ", __FILE__, __LINE__, __func__); \
             fprintf(stderr, __VA_ARGS__); \
             fprintf(stderr, "\n"); \
@@ -275,168 +427,7467 @@
     */
     benchmark_t* get_bench_instance(void);
 
-    // ═══════════════════════════════════════════════════════════════════════════════
-    // ███████████████████████ IMPLEMENTATION SECTION ███████████████████████████████
-    // ═══════════════════════════════════════════════════════════════════════════════
+    // ─── Memory Snapshots ────────────────────────────────────────────────────────
 
-        #ifdef BENCH_IMPLEMENTATION
+    /**
+    * @brief Point-in-time view of process memory as seen by the OS and by malloc.
+    *
+    * RSS comes from `/proc/self/statm`, heap figures from glibc `mallinfo2()`.
+    * Fields that are unavailable on the current platform are left at zero.
+    */
+    typedef struct {
+        size_t rss_bytes;         /**< Resident set size */
+        size_t heap_in_use;       /**< Bytes handed out by malloc (incl. mmapped chunks) */
+        size_t heap_free;         /**< Free bytes retained inside malloc arenas */
+        size_t heap_arena;        /**< Total bytes malloc obtained from the OS */
+        size_t heap_top;          /**< Releasable top chunk (part of heap_free) */
+    } bench_mem_snapshot_t;
 
-        static benchmark_t benchmarks;
+    /**
+    * @brief Capture the current memory snapshot without allocating.
+    * @param snap Output snapshot.
+    * @return 0 on success, -1 if RSS could not be read.
+    */
+    int bench_mem_sample(bench_mem_snapshot_t *snap);
 
-        benchmark_t* get_bench_instance(void) {
-            return &benchmarks;
-        }
+    /**
+    * @brief Fraction of malloc arena bytes that are free but not releasable (0.0 = compact).
+    *
+    * The untouched top chunk is free space the heap can still grow into or
+    * trim, not fragmentation, so it is left out: (free - top) / arena.
+    *
+    * @param snap Snapshot to evaluate.
+    * @return Fragmented/arena ratio, or 0.0 when heap statistics are unavailable.
+    */
+    double bench_mem_fragmentation(const bench_mem_snapshot_t *snap);
 
-        void benchmark_init(void) {
-            benchmarks.total_time = 0;   
-            benchmarks.timing_index = 0; 
-            benchmarks.start_time = 0;
-        }
+    /**
+    * @brief Enable or disable per-region memory capture at START/END of the calling thread.
+    *
+    * When enabled, every `START_TIMING()`/`END_TIMING()` pair records the RSS
+    * and heap delta, the heap fragmentation at exit and the peak RSS. With a
+    * non-zero `sampler_interval_ms` a background thread polls RSS inside the
+    * region, reading only `/proc/self/statm` so it never contends for malloc's
+    * locks. On Linux the kernel's high-water mark (VmHWM) is also reset through
+    * `/proc/self/clear_refs` at region entry and read at exit, which catches
+    * peaks of regions shorter than the polling period. Only regions of the
+    * calling thread are captured; RSS, heap and peak are still process-wide,
+    * so allocations by other threads during a region count towards it.
+    *
+    * @param enabled             Non-zero to capture, zero to stop.
+    * @param sampler_interval_ms Peak-RSS polling period, 0 for no sampler thread.
+    * @return 0 on success, -1 if the sampler thread could not be started.
+    */
+    int bench_mem_enable(int enabled, unsigned sampler_interval_ms);
 
-        long long get_time_us(void) {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC, &ts);
-            return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-        }
+    // ─── Soak Mode ───────────────────────────────────────────────────────────────
 
-        void record_timing(const char *function_name) {
-            if (benchmarks.timing_index >= MAX_FUNS_TO_BENCH) {
-                fprintf(stderr, "Error: Exceeded maximum number of benchmarked functions!\n");
-                return;
-            }
+    #define SOAK_SAMPLE_INTERVAL_US   10000   /**< Minimum spacing of memory samples during a soak. */
+    #define SOAK_BATCHES              32      /**< Time batches whose means the trends are fitted to. */
+    #define SOAK_MIN_VERDICT_S        10.0    /**< Shorter soaks report slopes but no drift verdict. */
+    #define SOAK_LATENCY_DRIFT_PCT    1.0     /**< Latency change over the soak (% of mean) worth reporting. */
+    #define SOAK_MEMORY_DRIFT_BYTES   1048576 /**< Memory change over the soak (bytes) worth reporting. */
+    #define SOAK_FRAG_DRIFT           0.01    /**< Fragmentation ratio change over the soak worth reporting. */
 
-            long long end_time = get_time_us();
-            benchmarks.timings[benchmarks.timing_index].time_us = end_time - benchmarks.start_time;
-            benchmarks.total_time += benchmarks.timings[benchmarks.timing_index].time_us;
+    /**
+    * @brief Signature of a benchmark body run repeatedly by the runners.
+    * @param arg User context passed through unchanged.
+    */
+    typedef void (*bench_fn)(void *arg);
 
-            strncpy(benchmarks.timings[benchmarks.timing_index].function_name, 
-                    function_name, 
-                    sizeof(benchmarks.timings[benchmarks.timing_index].function_name) - 1);
-            
-            benchmarks.timings[benchmarks.timing_index].function_name[
-                sizeof(benchmarks.timings[benchmarks.timing_index].function_name) - 1] = '\0';
+    /**
+    * @brief Least-squares trend of one metric against wall-clock time.
+    */
+    typedef struct {
+        double mean;              /**< Mean of the metric over the run */
+        double slope_per_hour;    /**< Fitted change per hour */
+        double ci95_per_hour;     /**< Half-width of the 95% confidence interval of the slope */
+        double change;            /**< Fitted change over the observed window */
+        int    judged;            /**< Zero if the soak was too short or had too few samples for a verdict */
+        int    drifting;          /**< Non-zero if the slope is significant and the change above threshold */
+    } bench_trend_t;
 
-            benchmarks.timing_index++;
-        }
+    /**
+    * @brief Result of a soak run.
+    */
+    typedef struct {
+        char          label[MAX_FUNS_NAME_LENGTH];  /**< Benchmark label */
+        size_t        repetitions;                  /**< Completed repetitions */
+        size_t        mem_samples;                  /**< Memory samples taken */
+        double        elapsed_s;                    /**< Wall time of the whole soak */
+        bench_trend_t latency_ns;                   /**< Per-repetition latency trend */
+        bench_trend_t rss_bytes;                    /**< Resident set size trend */
+        bench_trend_t heap_bytes;                   /**< Heap in-use trend */
+        bench_trend_t fragmentation;                /**< Heap fragmentation ratio trend */
+    } bench_soak_report_t;
 
-        scale get_scale(double v) {
-            if (v == 0.0) {
-                return scales[scale_nano_idx]; 
-            }
-            for (int i = scale_count - 1; i >= 0; --i) {
-                double scaled = v / scales[i].scale_divisor;
-                if (fabs(scaled) >= 1.0) {
-                    return scales[i];
-                }
-            }
-            return scales[scale_nano_idx]; 
-        }
+    /**
+    * @brief Repeat a benchmark for a fixed duration and fit drift trends.
+    *
+    * Every repetition is timed individually; RSS and heap statistics are sampled
+    * between repetitions (at most every SOAK_SAMPLE_INTERVAL_US) so that the
+    * sampling never falls inside a timed section. Consecutive samples are
+    * correlated, so trends are fitted to the means of SOAK_BATCHES equal time
+    * batches, which also keeps memory use constant regardless of the soak
+    * length. A metric drifts when its slope is significant and its fitted
+    * change over the soak exceeds the SOAK_*_DRIFT threshold; soaks shorter
+    * than SOAK_MIN_VERDICT_S give no verdict. The mean repetition time is also
+    * recorded under `label`.
+    *
+    * @param label      Label for the report and the timing table.
+    * @param fn         Benchmark body.
+    * @param arg        User context for `fn`.
+    * @param duration_s How long to keep repeating, in seconds.
+    * @param report     Output report (may be NULL to only record the timing).
+    * @return 0 on success, -1 on invalid arguments.
+    */
+    int bench_soak(const char *label, bench_fn fn, void *arg, double duration_s, bench_soak_report_t *report);
 
-        void format_scaled(double val, char *buffer, size_t buf_size, const char *unit) {
-            scale s = get_scale(val);
-            double scaled = val / s.scale_divisor;
-            snprintf(buffer, buf_size, "%7.3f %s%s", scaled, s.suffix, unit);
-        }
+    /**
+    * @brief Print a soak report with per-hour drift for latency and memory.
+    * @param report Report filled by `bench_soak()`.
+    */
+    void print_bench_soak(const bench_soak_report_t *report);
 
-        void FFT_bench(double mu_s, unsigned int FFT_size) {
-            if (mu_s <= 0.0f)
-                return;
+    // ─── Runner & Output Validation ──────────────────────────────────────────────
 
-            double fft_points = (double)FFT_size;
-            
-            // Radix-2 MFLOP/s formula (https://www.fftw.org/speed/)
-            double mflops = (5.0 * fft_points * log2(fft_points)) / (mu_s * scales[scale_micro_idx].scale_divisor);
+    #define MAX_CHECK_GROUPS       64      /**< Maximum number of comparison groups. */
 
-            char time_buffer[STRING_LENGTH];
-            char mflops_buffer[STRING_LENGTH];
+    /**
+    * @brief Cheap fingerprint of one iteration's output.
+    *
+    * `hash` is compared exactly; `value` (e.g. a sum of the outputs) is compared
+    * within the group's relative tolerance when one is set.
+    */
+    typedef struct {
+        uint64_t hash;            /**< Exact fingerprint of the output bytes */
+        double   value;           /**< Scalar summary for tolerance comparison */
+    } bench_digest_t;
 
-            format_scaled(mu_s * scales[scale_micro_idx].scale_divisor, time_buffer, STRING_LENGTH, "s");
-            format_scaled(mflops, mflops_buffer, STRING_LENGTH, "FLOP/s");
+    /**
+    * @brief Callback that digests the output produced by the last `bench_fn` call.
+    * @param arg User context (same as passed to the benchmark body).
+    * @param out Digest to fill.
+    */
+    typedef void (*bench_digest_fn)(void *arg, bench_digest_t *out);
 
-            fprintf(stdout, "%s%s%s", BAR_COLOR, line, RESET);
-            fprintf(stdout, "⏱️  %sFFT per frame%s  : %s%s%s (%.3f µs)\n", 
-                    BRIGHT_CYAN, RESET, BRIGHT_YELLOW, time_buffer, RESET, mu_s);
-            fprintf(stdout, "⚡  %sSpeed         %s  : %s%s%s (%.3f FLOP/s)\n", 
-                    BRIGHT_CYAN, RESET, BRIGHT_GREEN, mflops_buffer, RESET, mflops);
-            fprintf(stdout, "%s%s%s\n\n", BAR_COLOR, line, RESET);
-        }
+    /**
+    * @brief 64-bit FNV-1a hash of a byte range.
+    * @param data Bytes to hash.
+    * @param len  Number of bytes.
+    * @return Hash value.
+    */
+    uint64_t bench_hash_bytes(const void *data, size_t len);
 
-        int compare_times(const void *a, const void *b) {
-            const time_info *ta = (const time_info*)a;
-            const time_info *tb = (const time_info*)b;
-            
-            if (tb->time_us > ta->time_us) return 1;
-            if (tb->time_us < ta->time_us) return -1;
-            return 0;
-        }
+    /**
+    * @brief Digest a double array: exact byte hash plus compensated sum.
+    * @param v   Values.
+    * @param n   Number of values.
+    * @param out Digest to fill.
+    */
+    void bench_digest_f64(const double *v, size_t n, bench_digest_t *out);
 
-        const char* get_gradient_color(double percentage) {
-            if (percentage >= 80.0) return BRIGHT_RED;   
-            if (percentage >= 60.0) return RED;
-            if (percentage >= 40.0) return MAGENTA;
-            if (percentage >= 25.0) return BRIGHT_YELLOW;
-            if (percentage >= 15.0) return YELLOW;
-            if (percentage >= 5.0) return BRIGHT_GREEN;
-            if (percentage > 0.1) return GREEN;
-            return BLUE;  
-        }
+    /**
+    * @brief Set the relative tolerance for a comparison group.
+    *
+    * With a tolerance of 0 (the default) variants must produce identical
+    * hashes; otherwise their `value` fields must agree within `rel_tol`.
+    *
+    * @param group   Comparison group name.
+    * @param rel_tol Relative tolerance (e.g. 1e-9).
+    */
+    void bench_group_tolerance(const char *group, double rel_tol);
 
-        void print_bench_ranked(void) {
-            if (benchmarks.timing_index == 0) {
-                fprintf(stdout, "\nNo benchmark data available.\n");
-                return;
-            }
+    /**
+    * @brief Run a benchmark body `iterations` times and record the total time.
+    * @param label      Label for the timing table.
+    * @param fn         Benchmark body.
+    * @param arg        User context for `fn`.
+    * @param iterations Number of calls.
+    * @return 0 on success, -1 on invalid arguments.
+    */
+    int bench_run(const char *label, bench_fn fn, void *arg, size_t iterations);
 
-            qsort(benchmarks.timings, benchmarks.timing_index, sizeof(time_info), compare_times);
+    /**
+    * @brief Run a benchmark variant and validate its output against its group.
+    *
+    * After every timed call, `digest` (untimed) fingerprints the output. The
+    * first variant run in `group` becomes the reference; later variants must
+    * match it iteration by iteration. Variants that mismatch are flagged in
+    * the ranked and JSON output and excluded from the ranking.
+    *
+    * @param group      Comparison group name.
+    * @param label      Label for the timing table.
+    * @param fn         Benchmark body.
+    * @param digest     Output digest callback (NULL disables validation).
+    * @param arg        User context for `fn` and `digest`.
+    * @param iterations Number of calls.
+    * @return 0 if the outputs match, 1 on mismatch, -1 on invalid arguments.
+    */
+    int bench_run_checked(const char *group, const char *label, bench_fn fn,
+                          bench_digest_fn digest, void *arg, size_t iterations);
 
-            fprintf(stdout, "%s---------------------------------------------------------\n", BRIGHT_CYAN);
-            fprintf(stdout, "| %-20s | %-12s | %-7s |\n", "Function", "Exec Time", "% of total runtime");
-            fprintf(stdout, "---------------------------------------------------------%s\n", RESET);
+    // ─── Kernel Trace Markers ────────────────────────────────────────────────────
 
-            long long max_time = benchmarks.timings[0].time_us;
+    /**
+    * @brief Mirror START/END into the kernel trace via ftrace `trace_marker`.
+    *
+    * Each region boundary becomes a single preformatted write() so that regions
+    * line up with sched_switch, block I/O and other kernel events in trace-cmd
+    * or perf. Markers are written outside the timed interval; their cost is
+    * measured per write and reported under the ranked table.
+    *
+    * @param enabled Non-zero to open the marker file, zero to close it.
+    * @return 0 on success, -1 if no writable trace_marker was found.
+    */
+    int bench_ftrace_enable(int enabled);
 
-            for (size_t i = 0; i < benchmarks.timing_index; i++) {
-                double percentage = (double)benchmarks.timings[i].time_us * 100.0 / benchmarks.total_time;
-                int filled_length = (int)(BAR_LENGTH * percentage / 100.0);
+    // ─── Raw Samples & Statistics Kernels ────────────────────────────────────────
 
-                char time_str[STRING_LENGTH];
-                format_scaled(benchmarks.timings[i].time_us * scales[scale_micro_idx].scale_divisor, time_str, STRING_LENGTH, "s");
+    #define MAX_SAMPLE_LABELS      64      /**< Maximum number of labels keeping raw samples. */
 
-                const char *func_color = get_gradient_color((double)benchmarks.timings[i].time_us / max_time * 100.0);
+    /**
+    * @brief Raw per-call durations retained for one label.
+    */
+    typedef struct {
+        char     label[MAX_FUNS_NAME_LENGTH];         /**< Label the samples belong to */
+        int64_t *ns;                                  /**< Durations in nanoseconds */
+        size_t   count;                               /**< Samples stored */
+        size_t   capacity;                            /**< Allocated slots */
+        size_t   reservoir;                           /**< Reservoir size, 0 = keep everything */
+        size_t   seen;                                /**< Durations offered (>= count with a reservoir) */
+        int64_t  min, max;                            /**< Exact extremes over all seen durations */
+        double   mean, m2;                            /**< Exact running mean and squared deviations */
+        double   skip_w;                              /**< Algorithm L: current W */
+        size_t   skip_next;                           /**< Algorithm L: index of the next replacement */
+        size_t   throttled;                           /**< Regions that overlapped cgroup throttling */
+    } bench_samples_t;
 
-                fprintf(stdout, "%s| %-20s | %12s | %6.4f%% |%s\n",
-                        func_color, 
-                        benchmarks.timings[i].function_name,
-                        time_str,
-                        percentage,
-                        RESET);
+    /**
+    * @brief Summary statistics over a sample array.
+    */
+    typedef struct {
+        size_t  count;            /**< Number of samples */
+        int64_t min;              /**< Smallest sample */
+        int64_t max;              /**< Largest sample */
+        double  sum;              /**< Sum of samples */
+        double  sum_sq;           /**< Sum of squared deviations from the mean */
+        double  mean;             /**< Arithmetic mean */
+        double  stddev;           /**< Sample standard deviation */
+    } bench_stats_t;
 
-                printf("%s[", BRIGHT_CYAN);
-                for (int j = 0; j < filled_length; j++) printf("▰");
-                for (int j = 0; j < BAR_LENGTH - filled_length; j++) printf(" ");
-                printf("]%s\n", RESET);
-            }
+    /**
+    * @brief Instruction-set tiers for the statistics kernels.
+    */
+    typedef enum {
+        BENCH_SIMD_SCALAR = 0,    /**< Portable C */
+        BENCH_SIMD_SSE2,          /**< 128-bit, x86-64 baseline */
+        BENCH_SIMD_AVX2,          /**< 256-bit */
+        BENCH_SIMD_AVX512         /**< 512-bit (AVX-512F) */
+    } bench_simd_level;
 
-            fprintf(stdout, "%s---------------------------------------------------------\n%s", BRIGHT_CYAN, RESET);
-        }
+    /**
+    * @brief Start keeping raw samples for a label.
+    *
+    * Afterwards every `END_TIMING(label)` and every iteration of
+    * `bench_run(label, ...)` appends its duration.
+    *
+    * @param label Label to retain.
+    * @return 0 on success, -1 if the label table is full.
+    */
+    int bench_keep_samples(const char *label);
 
-        void print_bench_json(void) {
-            fprintf(stdout, ">>>{\n");
-            for (size_t i = 0; i < benchmarks.timing_index; i++) {
-                double percentage = (double)benchmarks.timings[i].time_us * 100.0 / benchmarks.total_time;
-                fprintf(stdout, "  \"%s\": {\"time_μs\": %lld, \"percentage\": %.2f}%s\n",
-                        benchmarks.timings[i].function_name,
-                        (long long)benchmarks.timings[i].time_us,
-                        percentage,
-                        (i < benchmarks.timing_index - 1) ? "," : "");
-            }
-            fprintf(stdout, "}<<<\n");
-        }
+    /**
+    * @brief Keep a bounded, uniformly random subset of a label's durations.
+    *
+    * Uses reservoir sampling (Algorithm L): once `k` samples are stored, only
+    * O(k log(n/k)) of the following durations touch the reservoir, so the
+    * per-call cost is a counter increment and a compare. Count, mean, standard
+    * deviation, min and max stay exact over every duration seen; percentiles
+    * and distribution comparisons use the reservoir. Samples the label already
+    * holds are cut to a uniform subset of `k`; a reservoir that has already
+    * dropped samples can shrink but not grow.
+    *
+    * @param label Label to retain.
+    * @param k     Reservoir size.
+    * @return 0 on success, -1 if the label table is full or memory is short.
+    */
+    int bench_keep_reservoir(const char *label, size_t k);
 
-        void print_bench(void) {
-            for (size_t i = 0; i < benchmarks.timing_index; i++) {
-                fprintf(stdout, "%s:%lld\n", benchmarks.timings[i].function_name, benchmarks.timings[i].time_us);
+    /**
+    * @brief Append one duration to a label's raw samples.
+    * @param label Label (must have been registered with `bench_keep_samples()`).
+    * @param ns    Duration in nanoseconds.
+    */
+    void bench_record_sample(const char *label, int64_t ns);
+
+    /**
+    * @brief Look up the raw samples of a label.
+    * @param label Label to look up.
+    * @return Sample set, or NULL if the label keeps no samples.
+    */
+    const bench_samples_t *bench_get_samples(const char *label);
+
+    /**
+    * @brief Select the kernel tier (clamped to what the CPU supports).
+    * @param level Highest tier to use.
+    * @return The tier actually selected.
+    */
+    bench_simd_level bench_simd_set(bench_simd_level level);
+
+    /**
+    * @brief Human-readable name of a kernel tier.
+    * @param level Tier.
+    * @return Name such as "avx2".
+    */
+    const char *bench_simd_name(bench_simd_level level);
+
+    /**
+    * @brief Compute count, min, max, sum, mean and standard deviation in one pass.
+    * @param v   Samples.
+    * @param n   Number of samples.
+    * @param out Statistics to fill.
+    */
+    void bench_stats_compute(const int64_t *v, size_t n, bench_stats_t *out);
+
+    /**
+    * @brief Count samples strictly greater than a threshold.
+    * @param v         Samples.
+    * @param n         Number of samples.
+    * @param threshold Threshold.
+    * @return Number of samples above the threshold.
+    */
+    size_t bench_count_above(const int64_t *v, size_t n, int64_t threshold);
+
+    /**
+    * @brief Bin samples into `bins` equal-width buckets over [lo, hi).
+    *
+    * Samples outside the range are counted in the first or last bucket.
+    * `counts` is accumulated into, not cleared.
+    *
+    * @param v      Samples.
+    * @param n      Number of samples.
+    * @param lo     Lower edge of the first bucket.
+    * @param hi     Upper edge of the last bucket.
+    * @param bins   Number of buckets.
+    * @param counts Bucket counters (`bins` entries).
+    */
+    void bench_histogram(const int64_t *v, size_t n, int64_t lo, int64_t hi, size_t bins, uint64_t *counts);
+
+    /**
+    * @brief Print count, mean, standard deviation, min and max per sampled label.
+    */
+    void print_bench_samples(void);
+
+    #define SPARKLINE_WIDTH        16      /**< Columns of the distribution sparkline. */
+
+    /**
+    * @brief Add a distribution sparkline column to `print_bench_ranked()`.
+    *
+    * Labels that keep samples get a Unicode histogram (▁▂▃▄▅▆▇█) of their
+    * latencies on a log scale shared by all rows, with the median bucket in
+    * green and the p99 bucket in red, so bimodal or long-tailed labels stand
+    * out next to their totals.
+    *
+    * @param enabled Non-zero to show the column.
+    */
+    void bench_ranked_sparklines(int enabled);
+
+    // ─── Exact Quantiles ─────────────────────────────────────────────────────────
+
+    #define BENCH_SELECT_MAX_QUANTILES  8    /**< Above this many quantiles a full radix sort is cheaper. */
+    #define BENCH_RADIX_PARALLEL_MIN    65536 /**< Smallest array sorted with several threads. */
+
+    /**
+    * @brief Set the number of threads used by report-time computations.
+    * @param threads Thread count (0 selects the number of online CPUs).
+    */
+    void bench_set_report_threads(unsigned threads);
+
+    /**
+    * @brief Number of threads used by report-time computations.
+    * @return Thread count (at least 1).
+    */
+    unsigned bench_report_threads(void);
+
+    /**
+    * @brief Sort 64-bit durations in place with a parallel LSD radix sort.
+    *
+    * Byte passes on which all keys agree are skipped, so typical durations
+    * (whose high bytes are constant) need only three to five passes.
+    *
+    * @param v Values to sort ascending.
+    * @param n Number of values.
+    * @return 0 on success, -1 if scratch memory could not be allocated.
+    */
+    int bench_sort_samples(int64_t *v, size_t n);
+
+    /**
+    * @brief Exact nearest-rank quantiles of a sample array (input is not modified).
+    *
+    * Up to BENCH_SELECT_MAX_QUANTILES quantiles are found with O(n) selection
+    * on a copy in the report scratch arena; more sort the copy with the radix
+    * sort of `bench_sort_samples()`. The arena is kept between calls.
+    *
+    * @param v   Samples.
+    * @param n   Number of samples.
+    * @param q   Quantiles in [0, 1].
+    * @param nq  Number of quantiles.
+    * @param out Quantile values (`nq` entries).
+    * @return 0 on success, -1 on empty input or allocation failure.
+    */
+    int bench_quantiles(const int64_t *v, size_t n, const double *q, size_t nq, int64_t *out);
+
+    // ─── Spans & Critical Path ───────────────────────────────────────────────────
+
+    #define MAX_SPANS              16384   /**< Maximum number of spans per run. */
+    #define MAX_SPAN_EDGES         32768   /**< Maximum number of span dependencies per run. */
+    #define MAX_SPAN_LABELS        64      /**< Maximum number of distinct span labels. */
+
+    /**
+    * @brief Handle of a recorded span; negative values are invalid.
+    */
+    typedef int bench_span_t;
+
+    #define BENCH_SPAN_INVALID     (-1)    /**< Returned when a span could not be recorded. */
+
+    /**
+    * @brief Opens a span, a timed unit of work in a task graph (thread-safe).
+    *
+    * Spans may begin and end on different threads; unlike timing regions they
+    * do not nest and are only reported by `print_bench_critical_path()`.
+    *
+    * @param label Stage name; spans sharing a label are aggregated.
+    * @return Span handle, or BENCH_SPAN_INVALID if the span table is full.
+    */
+    bench_span_t bench_span_begin(const char *label);
+
+    /**
+    * @brief Closes a span opened with `bench_span_begin()` (thread-safe).
+    * @param span Span handle.
+    */
+    void bench_span_end(bench_span_t span);
+
+    /**
+    * @brief Declares that `child` cannot start before `parent` has finished (thread-safe).
+    * @param child  Dependent span.
+    * @param parent Span it waits on.
+    * @return 0 on success, -1 on an invalid handle or a full edge table.
+    */
+    int bench_span_depends(bench_span_t child, bench_span_t parent);
+
+    /**
+    * @brief Prints the critical path through the recorded span DAG.
+    *
+    * Shows, per label, the time it contributes to the longest dependency
+    * chain and the slack of its spans that are off that chain.
+    */
+    void print_bench_critical_path(void);
+
+    // ─── Parallel Regions ────────────────────────────────────────────────────────
+
+    #define MAX_PAR_REGIONS        64      /**< Maximum number of parallel-region labels. */
+    #define MAX_PAR_THREADS        1024    /**< Maximum team size of a parallel region. */
+
+    /**
+    * @brief Per-thread accounting of a parallel region, one cache line each.
+    */
+    typedef struct {
+        int64_t mark;                  /**< Start of the open work or wait interval */
+        int64_t run_busy;              /**< Work time in the current execution */
+        int64_t busy;                  /**< Work time over all executions */
+        int64_t wait;                  /**< Barrier wait over all executions */
+        char    pad[64 - 4 * sizeof(int64_t)];
+    } bench_par_slot_t;
+
+    /**
+    * @brief A fork-join region executed by a team of threads.
+    */
+    typedef struct {
+        char              label[MAX_FUNS_NAME_LENGTH]; /**< Region label */
+        int               nthreads;                    /**< Team size of the current execution */
+        int               max_threads;                 /**< Largest team seen */
+        int               capacity;                    /**< Allocated slots */
+        bench_par_slot_t *slots;                       /**< Per-thread accounting */
+        size_t            runs;                        /**< Executions */
+        int64_t           start_ns;                    /**< Fork time of the current execution */
+        int64_t           wall_ns;                     /**< Fork-to-join time over all executions */
+        int64_t           thread_ns;                   /**< wall x team size over all executions */
+        int64_t           sum_max_busy;                /**< Sum over executions of the slowest thread's work */
+        double            sum_mean_busy;               /**< Sum over executions of the mean work per thread */
+        time_info        *entry;                       /**< Timing entry of the label, claimed at the first join */
+    } bench_par_t;
+
+    /**
+    * @brief Derived load-balance metrics of a parallel region.
+    */
+    typedef struct {
+        size_t  runs;                  /**< Executions */
+        int     threads;               /**< Largest team size */
+        int64_t wall_ns;               /**< Total fork-to-join time */
+        double  imbalance;             /**< Time-weighted max/mean work per execution (1 = perfect) */
+        int64_t lost_ns;               /**< Thread time not spent working (idle + waits) */
+        int64_t wait_ns;               /**< Measured barrier wait, all threads */
+        int64_t min_busy_ns;           /**< Least-loaded thread's total work */
+        int64_t max_busy_ns;           /**< Most-loaded thread's total work */
+        double  busy_cv;               /**< Coefficient of variation of per-thread work */
+    } bench_par_stats_t;
+
+    /**
+    * @brief Opens one execution of a parallel region (call on the forking thread).
+    *
+    * The region's wall time is also recorded as a regular timing entry by
+    * `bench_par_end()`, so it keeps its place in the ranked view. All executions
+    * of a label share one entry holding their total wall time.
+    *
+    * @param label    Region label; executions with the same label accumulate.
+    * @param nthreads Team size; threads are identified as 0..nthreads-1.
+    * @return Region handle, or NULL on error.
+    */
+    bench_par_t *bench_par_begin(const char *label, int nthreads);
+
+    /**
+    * @brief Marks the start of a thread's work inside the region (lock-free).
+    * @param r      Region handle.
+    * @param thread Thread index in the team.
+    */
+    void bench_par_work_begin(bench_par_t *r, int thread);
+
+    /**
+    * @brief Marks the end of a thread's work inside the region (lock-free).
+    * @param r      Region handle.
+    * @param thread Thread index in the team.
+    */
+    void bench_par_work_end(bench_par_t *r, int thread);
+
+    /**
+    * @brief Marks a thread arriving at a barrier (lock-free).
+    * @param r      Region handle.
+    * @param thread Thread index in the team.
+    */
+    void bench_par_wait_begin(bench_par_t *r, int thread);
+
+    /**
+    * @brief Marks a thread leaving a barrier (lock-free).
+    * @param r      Region handle.
+    * @param thread Thread index in the team.
+    */
+    void bench_par_wait_end(bench_par_t *r, int thread);
+
+    /**
+    * @brief Closes the current execution after the join (call on the forking thread).
+    * @param r Region handle.
+    */
+    void bench_par_end(bench_par_t *r);
+
+    /**
+    * @brief Computes load-balance metrics of a parallel region.
+    * @param label Region label.
+    * @param out   Metrics.
+    * @return 0 on success, -1 if the label has no executions.
+    */
+    int bench_par_stats(const char *label, bench_par_stats_t *out);
+
+    /**
+    * @brief Prints imbalance, lost time and per-thread spread of every parallel region.
+    */
+    void print_bench_parallel(void);
+
+    // ─── OpenMP Tool (OMPT) ──────────────────────────────────────────────────────
+
+    /**
+    * @brief Reports whether the built-in OMPT tool was activated by the OpenMP runtime.
+    *
+    * Compiling the implementation with `-DBENCH_OMPT` (plus the runtime's
+    * `omp-tools.h` on the include path) defines `ompt_start_tool()`, so an
+    * OMPT-capable runtime such as LLVM libomp times the program's OpenMP
+    * constructs with no annotations:
+    *   - parallel regions feed `bench_par_*` (team size, per-thread work, barrier waits);
+    *   - work-sharing loops and explicit tasks become spans, and task
+    *     dependences become span dependencies for `print_bench_critical_path()`.
+    * Nested parallel regions are folded into the outermost one.
+    *
+    * @return 1 if the tool is attached, 0 otherwise.
+    */
+    int bench_ompt_active(void);
+
+    // ─── Top-down Analysis ───────────────────────────────────────────────────────
+
+    #define TMA_BAR_WIDTH          20      /**< Width of the stacked top-down bar in the ranked view. */
+
+    /**
+    * @brief Attaches top-down counters to START/END regions of the calling thread.
+    *
+    * Counter groups are chosen from the PMU at hand:
+    *   - Intel with kernel topdown metrics (Ice Lake and later): slots + topdown-* events;
+    *   - older Intel: the kernel's topdown-slots-* aliases;
+    *   - AMD Zen 4 and later: dispatch-slot pipeline utilization events;
+    *   - anything else: generic stalled-cycles frontend/backend (a cycle-based subset).
+    * On Intel, the backend memory/core split comes from topdown-mem-bound or,
+    * failing that, from the CYCLE_ACTIVITY stall counters.
+    * Categories that cannot be measured are left out of `tma_mask`.
+    *
+    * @param enabled Non-zero to open the counters, zero to close them.
+    * @return 0 on success, -1 if no counter group could be opened.
+    */
+    int bench_tma_enable(int enabled);
+
+    /**
+    * @brief Categories measurable with the current counters.
+    * @return Bit (1u << class) per bench_tma_class, 0 when disabled.
+    */
+    unsigned bench_tma_available(void);
+
+    /**
+    * @brief Short description of the counter source in use ("none" when disabled).
+    * @return Static string.
+    */
+    const char *bench_tma_source(void);
+
+    /**
+    * @brief Display name of a top-down category.
+    * @param c Category.
+    * @return Static string.
+    */
+    const char *bench_tma_name(bench_tma_class c);
+
+    // ─── Replay Corpora ──────────────────────────────────────────────────────────
+
+    #define MAX_CORPUS_LABELS      32      /**< Maximum number of labels replaying a corpus. */
+    #define CORPUS_SIZE_BUCKETS    40      /**< Power-of-two record-size buckets (up to 512 GiB). */
+
+    #define BENCH_CORPUS_SHUFFLE   0x1u    /**< Visit records in a new random order on every pass. */
+    #define BENCH_CORPUS_PREFAULT  0x2u    /**< Fault all pages in at open time. */
+    #define BENCH_CORPUS_LOCK      0x4u    /**< mlock() the mapping so pages cannot be evicted. */
+
+    /**
+    * @brief One input record, pointing straight into the mapping (zero copy).
+    */
+    typedef struct {
+        const unsigned char *data;     /**< Record bytes */
+        size_t               size;     /**< Record length */
+    } bench_record_t;
+
+    /**
+    * @brief A memory-mapped input corpus.
+    *
+    * Either a single file of records, each preceded by its length as a 32-bit
+    * little-endian integer, or a directory whose regular files are one record each.
+    */
+    typedef struct {
+        bench_record_t *records;       /**< Records in file order */
+        size_t          count;         /**< Number of records */
+        size_t         *order;         /**< Visit order of the current pass */
+        size_t          cursor;        /**< Position in `order` */
+        size_t          passes;        /**< Completed passes */
+        unsigned        flags;         /**< BENCH_CORPUS_* options */
+        void          **maps;          /**< Mapped regions */
+        size_t         *map_sizes;     /**< Lengths of `maps` */
+        size_t          map_count;     /**< Number of mapped regions */
+        size_t          bytes;         /**< Total record bytes */
+    } bench_corpus_t;
+
+    /**
+    * @brief Signature of a body replaying one record.
+    * @param data Record bytes (read-only mapping).
+    * @param size Record length.
+    * @param arg  User context passed through unchanged.
+    */
+    typedef void (*bench_corpus_fn)(const unsigned char *data, size_t size, void *arg);
+
+    /**
+    * @brief Maps a corpus file or directory.
+    * @param corpus Corpus to initialise.
+    * @param path   Record file or directory.
+    * @param flags  BENCH_CORPUS_* options.
+    * @return 0 on success, -1 on I/O or format errors.
+    */
+    int bench_corpus_open(bench_corpus_t *corpus, const char *path, unsigned flags);
+
+    /**
+    * @brief Next record, wrapping around (and reshuffling) after the last one.
+    * @param corpus Open corpus.
+    * @return Record, or NULL if the corpus is empty.
+    */
+    const bench_record_t *bench_corpus_next(bench_corpus_t *corpus);
+
+    /**
+    * @brief Unmaps a corpus and frees its index.
+    * @param corpus Corpus to close.
+    */
+    void bench_corpus_close(bench_corpus_t *corpus);
+
+    /**
+    * @brief Replays `iterations` records through `fn`, timing each call.
+    *
+    * The total is recorded under `label`; per-call times are also kept per
+    * power-of-two record size for `print_bench_corpus()`.
+    *
+    * @param label      Label for the timing table.
+    * @param fn         Body called once per record.
+    * @param arg        User context for `fn`.
+    * @param corpus     Open corpus.
+    * @param iterations Number of records to replay (may exceed the corpus size).
+    * @return 0 on success, -1 on invalid arguments.
+    */
+    int bench_run_corpus(const char *label, bench_corpus_fn fn, void *arg, bench_corpus_t *corpus, size_t iterations);
+
+    /**
+    * @brief Prints replay results per label and record-size bucket.
+    */
+    void print_bench_corpus(void);
+
+    // ─── Causal Profiling ────────────────────────────────────────────────────────
+
+    #define MAX_PROGRESS_POINTS    32      /**< Maximum number of named progress points. */
+    #define MAX_CAUSAL_REGIONS     64      /**< Maximum number of regions causal experiments choose from. */
+    #define CAUSAL_SPEEDUP_STEPS   10      /**< Virtual speedups tried: 10%, 20%, ..., 100%. */
+
+    /**
+    * @brief Counts one unit of useful work at a named progress point (thread-safe).
+    *
+    * The name is resolved once per call site; afterwards a visit is one atomic
+    * increment. Progress points are also where threads pay causal-profiling delays.
+    *
+    * @param NAME Progress point name (string literal).
+    */
+    #define BENCH_PROGRESS(NAME) \
+        do { \
+            static uint64_t *bench_progress_counter_; \
+            if (!bench_progress_counter_) \
+                bench_progress_counter_ = bench_progress_point(NAME); \
+            if (bench_progress_counter_) \
+                __atomic_fetch_add(bench_progress_counter_, 1, __ATOMIC_RELAXED); \
+            bench_causal_point(); \
+        } while (0)
+
+    /**
+    * @brief Counter behind a named progress point, registered on first use.
+    * @param name Progress point name.
+    * @return Counter, or NULL if the table is full.
+    */
+    uint64_t *bench_progress_point(const char *name);
+
+    /**
+    * @brief Pays pending causal-profiling delays of the calling thread (no-op when inactive).
+    */
+    void bench_causal_point(void);
+
+    /**
+    * @brief Starts causal profiling (experimental, Coz-style virtual speedups).
+    *
+    * A background thread runs back-to-back experiments of `experiment_ms`.
+    * Each picks a region label seen so far (START/END regions and spans) and a
+    * virtual speedup. Every time a thread finishes that region, all other threads
+    * are delayed by the speedup times the region's duration. The delays are paid
+    * at region boundaries and progress points. The throughput of `progress`,
+    * measured over wall time minus inserted delay, then shows what a real speedup
+    * of the region would buy end to end. Half the experiments use no speedup and
+    * form the baseline.
+    *
+    * @param progress      Name of the progress point whose throughput is measured.
+    * @param experiment_ms Length of one experiment.
+    * @return 0 on success, -1 if the experiment thread could not be started.
+    */
+    int bench_causal_start(const char *progress, unsigned experiment_ms);
+
+    /**
+    * @brief Stops causal profiling after the current experiment.
+    */
+    void bench_causal_stop(void);
+
+    /**
+    * @brief Prints the per-region "virtual speedup vs throughput impact" curves.
+    */
+    void print_bench_causal(void);
+
+    // ─── Reference Kernels ───────────────────────────────────────────────────────
+
+    #define REF_KERNEL_RUNS        5                 /**< Passes per reference kernel; the fastest counts. */
+    #define REF_BUFFER_BYTES       (32u << 20)       /**< Working set of the memory kernels (beyond LLC). */
+    #define MAX_REF_LABELS         64                /**< Maximum number of labels with a normalization. */
+
+    /**
+    * @brief Fixed reference kernels used to normalize results across machines.
+    */
+    typedef enum {
+        BENCH_REF_INT = 0,        /**< Integer multiply/add/xor chains */
+        BENCH_REF_FP,             /**< Double-precision multiply-add chains */
+        BENCH_REF_LATENCY,        /**< Dependent loads over a random cycle */
+        BENCH_REF_BANDWIDTH,      /**< Streaming reads over a buffer beyond LLC */
+        BENCH_REF_COUNT
+    } bench_ref_kind;
+
+    /**
+    * @brief Runs the reference kernel suite (once per session; later calls are no-ops).
+    *
+    * Each kernel does a fixed amount of work; its score is the time of its
+    * fastest pass. The suite takes a few hundred milliseconds and is unaffected
+    * by benchmark_init().
+    *
+    * @return 0 on success, -1 if the memory kernels' buffer could not be allocated.
+    */
+    int bench_reference_run(void);
+
+    /**
+    * @brief Time of one pass of a reference kernel.
+    * @param kind Kernel.
+    * @return Pass time in µs, or 0.0 if the suite has not run.
+    */
+    double bench_reference_score(bench_ref_kind kind);
+
+    /**
+    * @brief Short name of a reference kernel ("int", "fp", "lat", "bw").
+    * @param kind Kernel.
+    * @return Static string.
+    */
+    const char *bench_reference_name(bench_ref_kind kind);
+
+    /**
+    * @brief Reports a label relative to the reference kernel that best matches its bottleneck.
+    *
+    * The ranked table and JSON output then show the label's time divided by one
+    * pass of that kernel, a unitless figure comparable across hosts. Runs the
+    * suite if it has not run yet.
+    *
+    * @param label Benchmark label.
+    * @param kind  Reference kernel to divide by.
+    * @return 0 on success, -1 if the label table is full or the suite failed.
+    */
+    int bench_normalize(const char *label, bench_ref_kind kind);
+
+    /**
+    * @brief Prints an environment header: host, kernel, CPU model and reference scores.
+    */
+    void print_bench_env(void);
+
+    // ─── ISA Variants ────────────────────────────────────────────────────────────
+
+    #define MAX_ISA_RESULTS        64      /**< Maximum number of kernel/ISA results kept for the report. */
+
+    /**
+    * @brief x86-64 micro-architecture levels a kernel can be compiled for.
+    */
+    typedef enum {
+        BENCH_ISA_BASELINE = 0,   /**< x86-64 (SSE2) */
+        BENCH_ISA_V2,             /**< x86-64-v2: SSE4.2, POPCNT */
+        BENCH_ISA_V3,             /**< x86-64-v3: AVX2, FMA, BMI2 */
+        BENCH_ISA_V4,             /**< x86-64-v4: AVX-512 F/BW/CD/DQ/VL */
+        BENCH_ISA_COUNT
+    } bench_isa_level;
+
+    /**
+    * @brief One compiled variant of a kernel.
+    */
+    typedef struct {
+        bench_isa_level level;    /**< Target level the body was compiled for */
+        bench_fn        fn;       /**< Entry point, NULL if not built on this platform */
+    } bench_isa_variant_t;
+
+    /**
+    * @brief Compiles a kernel body once per ISA level.
+    *
+    * Defines `static const bench_isa_variant_t NAME[BENCH_ISA_COUNT]` whose
+    * entries are `static void (void *ARG)` functions sharing the body, each with
+    * its own `target("arch=...")` attribute. Separate attributes rather than
+    * `target_clones` keep every variant directly callable, so all levels the host
+    * supports can be timed. Functions called from the body should be inlinable
+    * or plain; other targets' intrinsics are not available. Off x86-64 only the
+    * baseline is built.
+    *
+    * @param NAME Array name for the variants.
+    * @param ARG  Name of the `void *` parameter inside the body.
+    * @param ...  Function body (statements).
+    */
+    #if defined(__x86_64__) && defined(__GNUC__)
+        #define BENCH_ISA_KERNEL(NAME, ARG, ...) \
+            __attribute__((target("arch=x86-64")))    static void NAME##_x86_64(void *ARG) { __VA_ARGS__ } \
+            __attribute__((target("arch=x86-64-v2"))) static void NAME##_x86_64_v2(void *ARG) { __VA_ARGS__ } \
+            __attribute__((target("arch=x86-64-v3"))) static void NAME##_x86_64_v3(void *ARG) { __VA_ARGS__ } \
+            __attribute__((target("arch=x86-64-v4"))) static void NAME##_x86_64_v4(void *ARG) { __VA_ARGS__ } \
+            static const bench_isa_variant_t NAME[BENCH_ISA_COUNT] = { \
+                { BENCH_ISA_BASELINE, NAME##_x86_64 },    { BENCH_ISA_V2, NAME##_x86_64_v2 }, \
+                { BENCH_ISA_V3,       NAME##_x86_64_v3 }, { BENCH_ISA_V4, NAME##_x86_64_v4 } \
+            }
+    #else
+        #define BENCH_ISA_KERNEL(NAME, ARG, ...) \
+            static void NAME##_baseline(void *ARG) { __VA_ARGS__ } \
+            static const bench_isa_variant_t NAME[BENCH_ISA_COUNT] = { { BENCH_ISA_BASELINE, NAME##_baseline } }
+    #endif
+
+    /**
+    * @brief Whether the host CPU (and OS) can run code built for an ISA level.
+    * @param level ISA level.
+    * @return 1 if supported, 0 otherwise.
+    */
+    int bench_isa_supported(bench_isa_level level);
+
+    /**
+    * @brief Name of an ISA level ("x86-64", "x86-64-v2", ...).
+    * @param level ISA level.
+    * @return Static string.
+    */
+    const char *bench_isa_name(bench_isa_level level);
+
+    /**
+    * @brief Runs every ISA variant of a kernel the host supports.
+    *
+    * Each variant runs through bench_run_checked() as `label@<isa>` with
+    * `label` as its output-check group. With a digest, a variant whose output
+    * differs from the first one is flagged (e.g. FMA contraction changing
+    * rounding).
+    *
+    * @param label      Kernel label.
+    * @param variants   Array from BENCH_ISA_KERNEL().
+    * @param digest     Output digest function, or NULL to skip the check.
+    * @param arg        Argument passed to every call.
+    * @param iterations Calls per variant.
+    * @return Number of variants run, or -1 on error.
+    */
+    int bench_run_isa(const char *label, const bench_isa_variant_t *variants,
+                      bench_digest_fn digest, void *arg, size_t iterations);
+
+    /**
+    * @brief Prints per-ISA time and speedup over the baseline for every kernel run.
+    */
+    void print_bench_isa(void);
+
+    // ─── Layout Randomization ────────────────────────────────────────────────────
+
+    #define LAYOUT_MAX_STACK_PAD   4096    /**< Stack padding is drawn from [0, LAYOUT_MAX_STACK_PAD) bytes. */
+    #define LAYOUT_MAX_HEAP_OFFSET 4096    /**< Buffer start is drawn from [0, LAYOUT_MAX_HEAP_OFFSET) bytes into a page. */
+    #define LAYOUT_MAX_ENV_PAD     4096    /**< Environment padding of isolated runs, in bytes. */
+    #define LAYOUT_ALPHA           0.05    /**< Significance level for "layout matters". */
+
+    /**
+    * @brief Benchmark body for layout experiments; `buf` is a zeroed scratch buffer placed by the runner.
+    */
+    typedef void (*bench_layout_fn)(void *buf, size_t size, void *arg);
+
+    /**
+    * @brief Variance decomposition of a layout experiment (one-way ANOVA, layout as the factor).
+    */
+    typedef struct {
+        char   label[MAX_FUNS_NAME_LENGTH];  /**< Benchmark label */
+        size_t layouts;                     /**< Random layouts tried */
+        size_t samples;                     /**< Samples per layout */
+        double mean_ns;                     /**< Grand mean per call (or per process run) */
+        double layout_cv;                   /**< Std. dev. of the layout effect / mean */
+        double noise_cv;                    /**< Std. dev. within a layout / mean */
+        double layout_share;                /**< Fraction of the variance explained by layout */
+        double spread;                      /**< (slowest - fastest layout mean) / mean */
+        double f_stat;                      /**< Between / within mean squares */
+        double p_value;                     /**< P(F >= f_stat) if layout had no effect */
+    } bench_layout_report_t;
+
+    /**
+    * @brief Measures how much of a benchmark's variance comes from memory layout alone.
+    *
+    * Each of `layouts` random layouts pads the stack below `fn` (a VLA, like
+    * alloca) and places `buf` at a random 8-byte aligned offset into a page.
+    * Layouts are visited round-robin `samples` times, each sample timing
+    * `iterations` calls, so slow drift does not masquerade as a layout effect.
+    * The mean time per call is also recorded under `label`.
+    *
+    * @param label      Label for the report and the timing table.
+    * @param fn         Benchmark body.
+    * @param arg        User context for `fn`.
+    * @param buf_size   Size of the scratch buffer (0 for none).
+    * @param layouts    Number of random layouts (>= 2).
+    * @param samples    Samples per layout (>= 2).
+    * @param iterations Calls per sample.
+    * @param report     Output report.
+    * @return 0 on success, -1 on invalid arguments or allocation failure.
+    */
+    int bench_run_layout(const char *label, bench_layout_fn fn, void *arg, size_t buf_size,
+                         size_t layouts, size_t samples, size_t iterations, bench_layout_report_t *report);
+
+    /**
+    * @brief Same decomposition over whole processes, randomizing the environment size.
+    *
+    * Each layout adds a `BENCH_LAYOUT_PAD` variable of random length to the
+    * environment. This shifts the initial stack of the new process, as a
+    * different user name or working directory would. Every layout runs `argv`
+    * `samples` times through fork/exec with stdout discarded, and the wall time
+    * of each run is measured.
+    *
+    * @param label   Label for the report.
+    * @param argv    Command and arguments (argv[0] must be a path, PATH is not searched).
+    * @param layouts Number of environment sizes (>= 2).
+    * @param samples Runs per environment size (>= 2).
+    * @param report  Output report.
+    * @return 0 on success, -1 if a run could not be started or exited with an error.
+    */
+    int bench_layout_exec(const char *label, char *const argv[], size_t layouts, size_t samples,
+                          bench_layout_report_t *report);
+
+    /**
+    * @brief Print a layout report and the smallest speedup that layout alone cannot explain.
+    * @param report Report filled by `bench_run_layout()` or `bench_layout_exec()`.
+    */
+    void print_bench_layout(const bench_layout_report_t *report);
+
+    // ─── Distribution Shape ──────────────────────────────────────────────────────
+
+    #define KDE_GRID_POINTS        512     /**< Density evaluation points. */
+    #define KDE_MIN_SAMPLES        20      /**< Fewer samples give no shape analysis. */
+    #define KDE_MIN_STEPS          2.5     /**< Smallest bandwidth, in grid steps of the sample range. */
+    #define KDE_MODE_MIN_HEIGHT    0.05    /**< A peak below this fraction of the highest is ignored. */
+    #define KDE_MODE_MAX_DIP       0.80    /**< Peaks whose valley stays above this fraction of the lower peak merge. */
+    #define BENCH_MAX_MODES        4       /**< Modes reported per label. */
+    #define KS_ALPHA               0.01    /**< Significance level for "shape changed". */
+
+    /**
+    * @brief Modes of a label's latency distribution.
+    */
+    typedef struct {
+        size_t count;                       /**< Samples analyzed */
+        double bandwidth;                   /**< KDE bandwidth on the log-latency scale */
+        int    modes;                       /**< Modes found (may exceed BENCH_MAX_MODES) */
+        double mode_ns[BENCH_MAX_MODES];    /**< Latency at each mode, ascending */
+        double mode_mass[BENCH_MAX_MODES];  /**< Fraction of calls around each mode */
+    } bench_shape_t;
+
+    /**
+    * @brief Two-sample Kolmogorov-Smirnov comparison of two labels.
+    */
+    typedef struct {
+        char    label[MAX_FUNS_NAME_LENGTH];     /**< Candidate label */
+        char    baseline[MAX_FUNS_NAME_LENGTH];  /**< Baseline label */
+        size_t  n, m;                            /**< Sample counts (candidate, baseline) */
+        double  d;                               /**< Largest CDF distance */
+        double  p_value;                         /**< P(D >= d) if both came from one distribution */
+        int64_t at_ns;                           /**< Latency where the distance is largest */
+        double  cdf_label, cdf_baseline;         /**< Both CDFs at `at_ns` */
+        double  mean_shift;                      /**< Relative change of the mean */
+    } bench_ks_t;
+
+    /**
+    * @brief Estimates the density of a label's retained samples and counts its modes.
+    *
+    * A Gaussian KDE runs on log latency with Silverman's bandwidth, floored at
+    * KDE_MIN_STEPS grid steps so tight clusters still get smoothed. Local maxima
+    * below KDE_MODE_MIN_HEIGHT of the top peak are dropped. Neighbours that are
+    * not separated by a valley deeper than KDE_MODE_MAX_DIP are merged. Each
+    * mode's mass is the fraction of calls between its neighbouring valleys.
+    * There is no histogram fallback: the label must be registered with
+    * `bench_keep_samples()` or `bench_keep_reservoir()` before it runs.
+    *
+    * @param label Label keeping samples.
+    * @param out   Result.
+    * @return 0 on success, -1 if the label keeps no samples, has fewer than KDE_MIN_SAMPLES or memory is short.
+    */
+    int bench_shape(const char *label, bench_shape_t *out);
+
+    /**
+    * @brief Compares the latency distributions of two labels (two-sample KS test).
+    *
+    * Catches shape changes, such as a few percent of calls moving to a slow
+    * path, that hardly move the mean. Like `bench_shape()`, it reads only
+    * retained samples.
+    *
+    * @param label    Candidate label keeping samples.
+    * @param baseline Baseline label keeping samples (e.g. loaded with `bench_samples_load()`).
+    * @param out      Result.
+    * @return 0 on success, -1 if either label has no samples or memory is short.
+    */
+    int bench_ks_compare(const char *label, const char *baseline, bench_ks_t *out);
+
+    /**
+    * @brief Writes a label's retained samples, one nanosecond value per line.
+    * @param label Label keeping samples.
+    * @param path  Output file.
+    * @return 0 on success, -1 on error.
+    */
+    int bench_samples_save(const char *label, const char *path);
+
+    /**
+    * @brief Loads samples written by `bench_samples_save()` into a label (registered if needed).
+    * @param label Label to append to, e.g. "parse@baseline".
+    * @param path  Input file.
+    * @return Number of samples loaded, or -1 on error.
+    */
+    long bench_samples_load(const char *label, const char *path);
+
+    /**
+    * @brief Prints modes per sampled label and flags multimodal distributions.
+    */
+    void print_bench_shape(void);
+
+    /**
+    * @brief Prints a KS comparison, flagging shape changes even when the means agree.
+    * @param r Result filled by `bench_ks_compare()`.
+    */
+    void print_bench_ks(const bench_ks_t *r);
+
+    // ─── cgroup CPU Throttling ───────────────────────────────────────────────────
+
+    /**
+    * @brief Attributes cgroup CPU-quota throttling to regions.
+    *
+    * Locates the process's cgroup (v2 `cpu.stat` with `nr_throttled` /
+    * `throttled_usec`, or the v1 cpu controller on hybrid hosts). While enabled,
+    * every START/END region and bench_run() reads the counters at both ends.
+    * A region that saw throttling gets BENCH_ENTRY_THROTTLED, the throttled time
+    * and period count. Its raw sample, if kept, is counted as throttled. The
+    * counters are per cgroup, so with several busy threads the throttled time
+    * is shared by every region it overlapped. Each boundary costs one pread().
+    *
+    * @param enabled Non-zero to start, zero to stop.
+    * @return 0 on success, -1 if no cgroup CPU statistics are available.
+    */
+    int bench_cgroup_enable(int enabled);
+
+    /**
+    * @brief Effective CPU limit: the smallest quota/period along the cgroup path.
+    * @return Limit in CPUs, 0.0 if unlimited, -1.0 if the cgroup could not be read.
+    */
+    double bench_cgroup_cpu_limit(void);
+
+    // ─── Allocator Suite ─────────────────────────────────────────────────────────
+
+    #define MAX_ALLOC_RESULTS      128     /**< Maximum number of allocator/pattern/thread results kept. */
+    #define ALLOC_LATENCY_STRIDE   8       /**< Every Nth operation is timed individually. */
+    #define ALLOC_CHURN_SLOTS      1024    /**< Live objects per thread in the churn pattern. */
+    #define ALLOC_QUEUE_SLOTS      4096    /**< Producer/consumer queue capacity. */
+    #define ALLOC_REALLOC_MAX      (1u << 20) /**< Size at which a realloc growth chain restarts. */
+
+    /**
+    * @brief Allocator under test, as a malloc/free/realloc function table.
+    */
+    typedef struct {
+        const char *name;                                       /**< Label in the report */
+        void *(*malloc_fn)(size_t size, void *ctx);
+        void  (*free_fn)(void *ptr, void *ctx);
+        void *(*realloc_fn)(void *ptr, size_t size, void *ctx);
+        void  *ctx;                                             /**< Passed to every call */
+    } bench_allocator_t;
+
+    /**
+    * @brief Allocation patterns of the suite.
+    */
+    typedef enum {
+        BENCH_ALLOC_CHURN = 0,        /**< Random small-object frees and allocations over a live window */
+        BENCH_ALLOC_CROSS_THREAD,     /**< Producer threads allocate, consumer threads free */
+        BENCH_ALLOC_SIZE_SWEEP,       /**< Batches walking the size classes from 8 B to 32 KiB */
+        BENCH_ALLOC_REALLOC_GROWTH,   /**< Buffers grown by 1.5x with realloc up to ALLOC_REALLOC_MAX */
+        BENCH_ALLOC_PATTERN_COUNT
+    } bench_alloc_pattern;
+
+    /**
+    * @brief The C library's malloc/free/realloc.
+    */
+    extern const bench_allocator_t bench_allocator_libc;
+
+    /**
+    * @brief Runs every allocation pattern against an allocator with `threads` threads.
+    *
+    * Throughput is measured over the whole run. Every ALLOC_LATENCY_STRIDE-th
+    * call is timed on its own for the latency percentiles. Each pattern runs in
+    * a forked child, so no run inherits memory an earlier one freed; the child
+    * trims the C heap and resets the RSS high-water mark through
+    * /proc/self/clear_refs first. Every allocated byte is written. Peak RSS is
+    * the growth of the high-water mark. Overhead is the share of that growth
+    * not explained by the peak live bytes requested. Allocator state behind
+    * `ctx` is the child's copy. The cross-thread pattern pairs producers with
+    * consumers and so always uses an even number of threads (at least two).
+    *
+    * @param alloc          Allocator under test.
+    * @param threads        Worker threads (>= 1).
+    * @param ops_per_thread Allocator calls per thread and pattern.
+    * @return 0 on success, -1 on invalid arguments or if a run failed.
+    */
+    int bench_alloc_suite(const bench_allocator_t *alloc, unsigned threads, size_t ops_per_thread);
+
+    /**
+    * @brief Prints ops/s, latency percentiles, peak RSS and overhead per allocator, pattern and thread count.
+    */
+    void print_bench_alloc(void);
+
+    // ─── Clock Skew ──────────────────────────────────────────────────────────────
+
+    #define MAX_CLOCK_CPUS         1024    /**< Highest CPU number + 1 that calibration covers. */
+
+    /**
+    * @brief Estimates the clock offset of every allowed CPU against the lowest one.
+    *
+    * For each CPU, one thread pinned to the reference CPU and one pinned to the
+    * other CPU exchange `rounds` ping-pongs over a shared cache line. Each round
+    * gives offset = t_remote - (t_send + t_reply) / 2. The round with the
+    * shortest round trip is kept, and half of that round trip bounds the error.
+    * Spans record the CPU they begin and end on, and the critical path and trace
+    * export correct their timestamps onto the reference clock. An offset within
+    * its own bound is indistinguishable from zero and is not applied.
+    *
+    * @param rounds Ping-pongs per CPU (e.g. 1000).
+    * @return Number of CPUs calibrated besides the reference, or -1 if threads could not be pinned.
+    */
+    int bench_clock_calibrate(unsigned rounds);
+
+    /**
+    * @brief Calibrated offset of a CPU's clock relative to the reference CPU.
+    * @param cpu CPU number.
+    * @return Offset in ns (0 if not calibrated).
+    */
+    int64_t bench_clock_offset(int cpu);
+
+    /**
+    * @brief Largest residual skew after correction, over all CPUs.
+    *
+    * Half the best round trip for corrected CPUs; for CPUs left uncorrected, the
+    * measured offset plus that half round trip.
+    * @return Bound in ns, or -1 if not calibrated.
+    */
+    int64_t bench_clock_skew_bound(void);
+
+    /**
+    * @brief Writes all spans as a Chrome trace (chrome://tracing, Perfetto).
+    *
+    * Timestamps are corrected per CPU. The skew calibration, the offset applied
+    * to each CPU, the residual bound and the number of spans that still end
+    * before they start are stored under "otherData".
+    *
+    * @param path Output file.
+    * @return Number of spans written, or -1 on error.
+    */
+    int bench_trace_export(const char *path);
+
+    /**
+    * @brief Prints per-CPU clock offsets and residual bounds.
+    */
+    void print_bench_clock_skew(void);
+
+    // ─── Auto-tuning & Wisdom ────────────────────────────────────────────────────
+
+    #define MAX_TUNE_PARAMS        8       /**< Maximum number of parameters in a tuning space. */
+    #define MAX_TUNE_CONFIGS       65536   /**< Maximum number of configurations in a tuning space. */
+    #define MAX_TUNE_RESULTS       64      /**< Maximum number of tuning runs kept for printing. */
+    #define MAX_WISDOM_ENTRIES     256     /**< Maximum number of wisdom entries (all machines). */
+    #define TUNE_PARAM_NAME_LENGTH 32      /**< Maximum length of a parameter name. */
+    #define TUNE_RANDOM_TRIALS     16      /**< Configurations drawn by random search when `trials` is 0. */
+
+    /**
+    * @brief One tunable parameter: a name and the values it may take.
+    */
+    typedef struct {
+        const char *name;             /**< e.g. "block", "unroll", "threads", "variant" (no whitespace) */
+        const int  *values;           /**< Candidate values; the first is the default */
+        size_t      count;
+    } bench_tune_param_t;
+
+    /**
+    * @brief One point of a tuning space: `values[i]` is the value of parameter i.
+    */
+    typedef struct {
+        int values[MAX_TUNE_PARAMS];
+    } bench_tune_config_t;
+
+    /**
+    * @brief Tunable kernel: one call at problem size `n` with configuration `cfg`.
+    */
+    typedef void (*bench_tune_fn)(const bench_tune_config_t *cfg, size_t n, void *arg);
+
+    /**
+    * @brief A kernel and the parameter space it is tuned over.
+    */
+    typedef struct {
+        const char               *name;         /**< Wisdom key (no whitespace) */
+        const bench_tune_param_t *params;
+        size_t                    param_count;
+        bench_tune_fn             fn;
+        void                     *arg;          /**< Passed to every call */
+    } bench_tune_space_t;
+
+    /**
+    * @brief Search strategies of bench_tune().
+    */
+    typedef enum {
+        BENCH_TUNE_GRID,              /**< Every configuration */
+        BENCH_TUNE_RANDOM,            /**< `trials` configurations drawn without replacement */
+        BENCH_TUNE_HALVING            /**< Successive halving: drop the slower half, double the calls */
+    } bench_tune_strategy;
+
+    /**
+    * @brief Searches a parameter space for the fastest configuration at one problem size.
+    *
+    * A configuration is scored by the median of `iterations` timed calls after
+    * one warm-up call. Random search and successive halving always include the
+    * default configuration (the first value of every parameter). Successive
+    * halving starts from `trials` candidates (0 = all), keeps the faster half
+    * after each round and doubles the calls per candidate, so every round costs
+    * about the same. The winner is stored as wisdom for this machine, replacing
+    * any earlier entry for the same space and size.
+    *
+    * @param space      Kernel and parameters.
+    * @param n          Problem size, passed to the kernel and used as the wisdom key.
+    * @param strategy   Search strategy.
+    * @param trials     Candidates for random search and halving (0 = default); ignored by grid.
+    * @param iterations Timed calls per candidate (first round for halving).
+    * @param best       Receives the winning configuration (may be NULL).
+    * @return Number of configurations measured, or -1 on error.
+    */
+    int bench_tune(const bench_tune_space_t *space, size_t n, bench_tune_strategy strategy,
+                   size_t trials, size_t iterations, bench_tune_config_t *best);
+
+    /**
+    * @brief Looks up the tuned configuration for a space and size in the wisdom.
+    *
+    * Uses the entry for exactly `n` when there is one, otherwise the entry for
+    * the nearest tuned size (by ratio). Entries of other machines, or whose
+    * values are no longer in the space, are ignored.
+    *
+    * @param space Kernel and parameters.
+    * @param n     Problem size.
+    * @param cfg   Receives the configuration; the default one on a miss.
+    * @return 0 on a hit, -1 on a miss.
+    */
+    int bench_tune_lookup(const bench_tune_space_t *space, size_t n, bench_tune_config_t *cfg);
+
+    /**
+    * @brief Calls the kernel once with its tuned configuration for size `n` (default on a miss).
+    *
+    * The last lookup is cached per thread, so repeated calls with the same
+    * space and size cost one comparison.
+    *
+    * @param space Kernel and parameters.
+    * @param n     Problem size.
+    * @return 0 if wisdom was used, -1 if the default configuration was.
+    */
+    int bench_tune_dispatch(const bench_tune_space_t *space, size_t n);
+
+    /**
+    * @brief Fingerprint of this machine that keys the wisdom.
+    *
+    * Hash of the CPU model, online CPU count, architecture and cgroup CPU
+    * limit, so wisdom does not follow a file to a different host or quota.
+    *
+    * @return 16 hex digits (static string).
+    */
+    const char *bench_machine_fingerprint(void);
+
+    /**
+    * @brief Merges a wisdom file into memory (entries of all machines are kept).
+    * @param path File written by bench_wisdom_save().
+    * @return Number of entries for this machine, or -1 if the file cannot be read.
+    */
+    int bench_wisdom_load(const char *path);
+
+    /**
+    * @brief Writes all wisdom in memory to a file.
+    * @param path Output path.
+    * @return Number of entries written, or -1 on error.
+    */
+    int bench_wisdom_save(const char *path);
+
+    /**
+    * @brief Prints every tuning run: strategy, cost, winner and its speedup over the default.
+    */
+    void print_bench_tune(void);
+
+    // ─── Cold Page Cache I/O ─────────────────────────────────────────────────────
+
+    #define MAX_COLD_FILES         8       /**< Maximum number of files evicted before each bench_run() iteration. */
+    #define MAX_IO_RESULTS         64      /**< Maximum number of cold/warm I/O comparisons kept. */
+    #define MAX_COLD_PATH          512     /**< Maximum length of a cold file path. */
+
+    /**
+    * @brief Evicts a file from the page cache before every bench_run() iteration.
+    *
+    * Before each call the file is fsync()ed, so dirty pages can be dropped, and
+    * then released with `posix_fadvise(POSIX_FADV_DONTNEED)`. Neither needs
+    * root. The eviction is not timed. Pages that another process has mapped or
+    * locked stay resident.
+    *
+    * @param path File to evict, or NULL to clear the list.
+    * @return 0 on success, -1 if the list is full or the file cannot be opened.
+    */
+    int bench_cold_file(const char *path);
+
+    /**
+    * @brief Fraction of a file's pages in the page cache, from `mincore()`.
+    * @param path File to inspect.
+    * @return Fraction in [0, 1], or -1 on error.
+    */
+    double bench_page_residency(const char *path);
+
+    /**
+    * @brief Times an I/O benchmark with a cold and with a warm page cache.
+    *
+    * Runs `iterations` calls as `label@cold`, evicting `path` (and any file
+    * registered with bench_cold_file()) before each one. The eviction is
+    * checked with `mincore()`. Then runs one untimed call to fill the cache
+    * and `iterations` calls as `label@warm`. Both appear in the ranked table
+    * and in print_bench_io().
+    *
+    * @param label      Benchmark label.
+    * @param path       File the benchmark reads.
+    * @param fn         Benchmark body.
+    * @param arg        Argument passed to every call.
+    * @param bytes      Bytes moved per call, or 0 for the file size.
+    * @param iterations Calls per mode.
+    * @return 0 on success, -1 on error.
+    */
+    int bench_run_io(const char *label, const char *path, bench_fn fn, void *arg,
+                     size_t bytes, size_t iterations);
+
+    /**
+    * @brief Prints cold and warm time and throughput side by side, with the eviction achieved.
+    */
+    void print_bench_io(void);
+
+    // ═══════════════════════════════════════════════════════════════════════════════
+    // ███████████████████████ IMPLEMENTATION SECTION ███████████████████████████████
+    // ═══════════════════════════════════════════════════════════════════════════════
+
+        #ifdef BENCH_IMPLEMENTATION
+
+        #include <unistd.h>
+        #include <fcntl.h>
+        #include <pthread.h>
+        #include <dirent.h>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <sys/utsname.h>
+        #include <sys/wait.h>
+        #include <sched.h>
+
+        #if defined(__linux__)
+            #include <sys/syscall.h>
+        #endif
+
+        #if defined(__x86_64__) && defined(__GNUC__)
+            #include <immintrin.h>
+            #include <cpuid.h>
+        #endif
+
+        #if defined(__linux__)
+            #include <linux/perf_event.h>
+            #include <sys/ioctl.h>
+            #define BENCH_HAVE_PERF
+        #endif
+
+        #if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+            #include <malloc.h>
+            #define BENCH_HAVE_MALLINFO2
+        #endif
+
+        static benchmark_t benchmarks;
+        static int         timing_table_full;         // the overflow error is printed once per init
+        static __thread int64_t region_start_ns;     // regions are timed per thread
+
+        #if defined(BENCH_HAVE_USDT)
+            // Tracers increment these to request the probe's costlier arguments.
+            __attribute__((section(".probes"), used)) volatile unsigned short bench_sdt_region_begin_semaphore;
+            __attribute__((section(".probes"), used)) volatile unsigned short bench_sdt_region_end_semaphore;
+            __attribute__((section(".probes"), used)) volatile unsigned short bench_sdt_log_semaphore;
+        #endif
+
+        // Optional region hooks; each feature defines its half further below.
+        static __thread int mem_owner;
+        static void mem_region_begin(void);
+        static void mem_region_end(time_info *entry);
+        static void check_groups_reset(void);
+        static int  ftrace_fd = -1;
+        static void ftrace_region_begin(void);
+        static void ftrace_region_end(const time_info *entry);
+        static void print_ftrace_overhead(void);
+        static size_t sample_set_count;
+        static void bench_record_sample_entry(const char *label, int64_t ns);
+        static void samples_reset(void);
+        static void arena_release(void);
+        static int  ranked_sparklines;
+        static int  sparkline_range(int64_t *lo, int64_t *hi);
+        static void print_sparkline(const char *label, int64_t lo, int64_t hi);
+        static void print_sparkline_legend(int64_t lo, int64_t hi);
+        static __thread int tma_owner;
+        static void tma_region_begin(void);
+        static void tma_region_end(time_info *entry);
+        static void print_tma_bar(const time_info *entry);
+        static void print_tma_legend(void);
+        static const char *const tma_keys[BENCH_TMA_COUNT] = {
+            "retiring", "bad_speculation", "frontend", "backend", "backend_memory", "backend_core"
+        };
+        static void spans_reset(void);
+        static void corpus_results_reset(void);
+        static void isa_results_reset(void);
+        static void alloc_results_reset(void);
+        static void tune_results_reset(void);
+        static void io_results_reset(void);
+        static size_t cold_file_count;
+        static void cold_evict_all(void);
+        static int  causal_active;
+        static int  ref_label_kind(const char *label);
+        static void print_ref_cell(const time_info *entry);
+        static void print_ref_legend(void);
+        static int  cgroup_stat_fd = -1;
+        static void cgroup_region_begin(void);
+        static void cgroup_region_end(time_info *entry);
+        static void print_cgroup_legend(void);
+        static bench_samples_t *find_samples(const char *label);
+        static int64_t clock_correct(int64_t ns, int cpu);
+        static void causal_region_end(const char *label, int64_t elapsed_ns);
+        static void par_regions_reset(void);
+
+        benchmark_t* get_bench_instance(void) {
+            return &benchmarks;
+        }
+
+        void benchmark_init(void) {
+            benchmarks.total_time = 0;   
+            benchmarks.timing_index = 0; 
+            benchmarks.start_time = 0;
+            timing_table_full = 0;
+            check_groups_reset();
+            samples_reset();
+            arena_release();
+            spans_reset();
+            par_regions_reset();
+            corpus_results_reset();
+            isa_results_reset();
+            alloc_results_reset();
+            tune_results_reset();
+            io_results_reset();
+        }
+
+        long long get_time_us(void) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+
+        int64_t get_time_ns(void) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+        }
+
+        static uint64_t rng_state = 0x853c49e6748fea9bULL;
+
+        void bench_seed(uint64_t seed) {
+            rng_state = seed;
+        }
+
+        uint64_t bench_random(void) {
+            uint64_t z = (rng_state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        /** Uniform double in the open interval (0, 1). */
+        static double random_unit(void) {
+            return ((double)(bench_random() >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        }
+
+        long bench_thread_id(void) {
+        #if defined(__linux__)
+            return (long)syscall(SYS_gettid);
+        #else
+            return (long)(uintptr_t)pthread_self();
+        #endif
+        }
+
+        void bench_region_begin(void) {
+            BENCH_USDT1(region_begin, BENCH_USDT_ENABLED(region_begin) ? bench_thread_id() : 0);
+            if (mem_owner)
+                mem_region_begin();
+            if (ftrace_fd >= 0)
+                ftrace_region_begin();
+            if (tma_owner)
+                tma_region_begin();
+            if (causal_active)
+                bench_causal_point();
+            if (cgroup_stat_fd >= 0)
+                cgroup_region_begin();
+            region_start_ns = get_time_ns();
+            __atomic_store_n(&benchmarks.start_time, (long long)(region_start_ns / 1000), __ATOMIC_RELAXED);
+        }
+
+        static time_info *record_entry(const char *function_name, long long time_us) {
+            // Slots are claimed with a CAS so concurrent recorders never pass the table end.
+            size_t index = __atomic_load_n(&benchmarks.timing_index, __ATOMIC_RELAXED);
+            do {
+                if (index >= MAX_FUNS_TO_BENCH) {
+                    if (!__atomic_exchange_n(&timing_table_full, 1, __ATOMIC_RELAXED))
+                        fprintf(stderr, "Error: Exceeded maximum number of benchmarked functions!\n");
+                    return NULL;
+                }
+            } while (!__atomic_compare_exchange_n(&benchmarks.timing_index, &index, index + 1, 1,
+                                                  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+            time_info *entry = &benchmarks.timings[index];
+            memset(entry, 0, sizeof(*entry));
+
+            entry->time_us = time_us;
+            __atomic_fetch_add(&benchmarks.total_time, time_us, __ATOMIC_RELAXED);
+
+            strncpy(entry->function_name, function_name, sizeof(entry->function_name) - 1);
+            entry->function_name[sizeof(entry->function_name) - 1] = '\0';
+            return entry;
+        }
+
+        void record_timing(const char *function_name) {
+            // Samples, shapes and causal delays need ns; the timing table keeps µs.
+            int64_t   elapsed_ns = get_time_ns() - region_start_ns;
+            long long elapsed    = (long long)((elapsed_ns + 500) / 1000);
+            time_info *entry = record_entry(function_name, elapsed);
+
+            // Sample sets outlive the timing table: a reservoir covers an unbounded stream.
+            if (sample_set_count)
+                bench_record_sample_entry(function_name, elapsed_ns);
+            if (entry && mem_owner)
+                mem_region_end(entry);
+            if (entry && ftrace_fd >= 0)
+                ftrace_region_end(entry);
+            if (entry && tma_owner)
+                tma_region_end(entry);
+            if (entry && cgroup_stat_fd >= 0) {
+                cgroup_region_end(entry);
+                bench_samples_t *set = (entry->flags & BENCH_ENTRY_THROTTLED) ? find_samples(function_name) : NULL;
+                if (set)
+                    set->throttled++;
+            }
+            if (causal_active)
+                causal_region_end(function_name, elapsed_ns);
+
+            BENCH_USDT3(region_end, (intptr_t)function_name, elapsed,
+                        BENCH_USDT_ENABLED(region_end) ? bench_thread_id() : 0);
+        }
+
+        void record_timing_us(const char *function_name, long long time_us) {
+            record_entry(function_name, time_us);
+        }
+
+        scale get_scale(double v) {
+            if (v == 0.0) {
+                return scales[scale_nano_idx]; 
+            }
+            for (int i = scale_count - 1; i >= 0; --i) {
+                double scaled = v / scales[i].scale_divisor;
+                if (fabs(scaled) >= 1.0) {
+                    return scales[i];
+                }
+            }
+            return scales[scale_nano_idx]; 
+        }
+
+        void format_scaled(double val, char *buffer, size_t buf_size, const char *unit) {
+            scale s = get_scale(val);
+            double scaled = val / s.scale_divisor;
+            snprintf(buffer, buf_size, "%7.3f %s%s", scaled, s.suffix, unit);
+        }
+
+        void FFT_bench(double mu_s, unsigned int FFT_size) {
+            if (mu_s <= 0.0f)
+                return;
+
+            double fft_points = (double)FFT_size;
+            
+            // Radix-2 MFLOP/s formula (https://www.fftw.org/speed/)
+            double mflops = (5.0 * fft_points * log2(fft_points)) / (mu_s * scales[scale_micro_idx].scale_divisor);
+
+            char time_buffer[STRING_LENGTH];
+            char mflops_buffer[STRING_LENGTH];
+
+            format_scaled(mu_s * scales[scale_micro_idx].scale_divisor, time_buffer, STRING_LENGTH, "s");
+            format_scaled(mflops, mflops_buffer, STRING_LENGTH, "FLOP/s");
+
+            fprintf(stdout, "%s%s%s", BAR_COLOR, line, RESET);
+            fprintf(stdout, "⏱️  %sFFT per frame%s  : %s%s%s (%.3f µs)\n", 
+                    BRIGHT_CYAN, RESET, BRIGHT_YELLOW, time_buffer, RESET, mu_s);
+            fprintf(stdout, "⚡  %sSpeed         %s  : %s%s%s (%.3f FLOP/s)\n", 
+                    BRIGHT_CYAN, RESET, BRIGHT_GREEN, mflops_buffer, RESET, mflops);
+            fprintf(stdout, "%s%s%s\n\n", BAR_COLOR, line, RESET);
+        }
+
+        int compare_times(const void *a, const void *b) {
+            const time_info *ta = (const time_info*)a;
+            const time_info *tb = (const time_info*)b;
+            
+            if (tb->time_us > ta->time_us) return 1;
+            if (tb->time_us < ta->time_us) return -1;
+            return 0;
+        }
+
+        const char* get_gradient_color(double percentage) {
+            if (percentage >= 80.0) return BRIGHT_RED;   
+            if (percentage >= 60.0) return RED;
+            if (percentage >= 40.0) return MAGENTA;
+            if (percentage >= 25.0) return BRIGHT_YELLOW;
+            if (percentage >= 15.0) return YELLOW;
+            if (percentage >= 5.0) return BRIGHT_GREEN;
+            if (percentage > 0.1) return GREEN;
+            return BLUE;  
+        }
+
+        static int any_entry_has(unsigned flag) {
+            for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                if (benchmarks.timings[i].flags & flag)
+                    return 1;
+            }
+            return 0;
+        }
+
+        /** Optional columns of the ranked table, decided once per print. */
+        typedef struct {
+            int     mem;              /**< RSS delta / peak / fragmentation */
+            int     spark;            /**< Distribution sparkline */
+            int     tma;              /**< Top-down stacked bar */
+            int     norm;             /**< Time relative to a reference kernel */
+            int     throttle;         /**< cgroup throttled time */
+            int64_t spark_lo;         /**< Shared sparkline range (ns) */
+            int64_t spark_hi;
+        } ranked_layout_t;
+
+        static void print_ranked_rule(const ranked_layout_t *layout) {
+            fprintf(stdout, "%s---------------------------------------------------------", BRIGHT_CYAN);
+            if (layout->mem)
+                fprintf(stdout, "----------------------------------------");
+            if (layout->spark)
+                for (int j = 0; j < SPARKLINE_WIDTH + 3; j++) fprintf(stdout, "-");
+            if (layout->tma)
+                for (int j = 0; j < TMA_BAR_WIDTH + 3; j++) fprintf(stdout, "-");
+            if (layout->norm)
+                fprintf(stdout, "---------------");
+            if (layout->throttle)
+                fprintf(stdout, "---------------");
+            fprintf(stdout, "%s\n", RESET);
+        }
+
+        static long long ranked_total_time(void) {
+            long long total = 0;
+            for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                if (!(benchmarks.timings[i].flags & BENCH_ENTRY_MISMATCH))
+                    total += benchmarks.timings[i].time_us;
+            }
+            return total;
+        }
+
+        static void print_ranked_row(const time_info *t, long long total, long long max_time, const ranked_layout_t *layout) {
+            int mismatch = (t->flags & BENCH_ENTRY_MISMATCH) != 0;
+            double percentage = (!mismatch && total > 0) ? (double)t->time_us * 100.0 / total : 0.0;
+            int filled_length = (int)(BAR_LENGTH * percentage / 100.0);
+
+            char time_str[STRING_LENGTH];
+            format_scaled(t->time_us * scales[scale_micro_idx].scale_divisor, time_str, STRING_LENGTH, "s");
+
+            const char *func_color = mismatch ? RED
+                                   : get_gradient_color(max_time > 0 ? (double)t->time_us / max_time * 100.0 : 0.0);
+
+            if (mismatch) {
+                fprintf(stdout, "%s| %-20s | %12s | %-7s |", func_color, t->function_name, time_str, "✗ WRONG");
+            } else {
+                fprintf(stdout, "%s| %-20s | %12s | %6.4f%% |",
+                        func_color, 
+                        t->function_name,
+                        time_str,
+                        percentage);
+            }
+
+            if (layout->mem) {
+                if (t->flags & BENCH_ENTRY_MEM) {
+                    char delta_str[STRING_LENGTH], peak_str[STRING_LENGTH];
+                    format_scaled((double)t->rss_delta, delta_str, STRING_LENGTH, "B");
+                    format_scaled((double)t->peak_rss, peak_str, STRING_LENGTH, "B");
+                    fprintf(stdout, " %11s | %11s | %5.1f%% |", delta_str, peak_str, t->fragmentation * 100.0);
+                } else {
+                    fprintf(stdout, " %11s | %11s | %6s |", "-", "-", "-");
+                }
+            }
+            if (layout->spark) {
+                fprintf(stdout, " ");
+                print_sparkline(t->function_name, layout->spark_lo, layout->spark_hi);
+                fprintf(stdout, "%s |", func_color);
+            }
+            if (layout->tma) {
+                fprintf(stdout, " ");
+                print_tma_bar(t);
+                fprintf(stdout, "%s |", func_color);
+            }
+            if (layout->norm) {
+                fprintf(stdout, " ");
+                print_ref_cell(t);
+                fprintf(stdout, "%s |", func_color);
+            }
+            if (layout->throttle) {
+                if (t->flags & BENCH_ENTRY_THROTTLED) {
+                    char throttled_str[STRING_LENGTH];
+                    format_scaled(t->throttled_us * scales[scale_micro_idx].scale_divisor, throttled_str, STRING_LENGTH, "s");
+                    fprintf(stdout, " %s%12s%s |", BRIGHT_RED, throttled_str, func_color);
+                } else {
+                    fprintf(stdout, " %12s |", "-");
+                }
+            }
+            fprintf(stdout, "%s\n", RESET);
+
+            if (mismatch) {
+                fprintf(stdout, "%s[output mismatch - excluded from ranking]%s\n", RED, RESET);
+                return;
+            }
+
+            printf("%s[", BRIGHT_CYAN);
+            for (int j = 0; j < filled_length; j++) printf("▰");
+            for (int j = 0; j < BAR_LENGTH - filled_length; j++) printf(" ");
+            printf("]%s\n", RESET);
+        }
+
+        void print_bench_ranked(void) {
+            if (benchmarks.timing_index == 0) {
+                fprintf(stdout, "\nNo benchmark data available.\n");
+                return;
+            }
+
+            qsort(benchmarks.timings, benchmarks.timing_index, sizeof(time_info), compare_times);
+
+            ranked_layout_t layout = { 0, 0, 0, 0, 0, 0, 0 };
+            layout.mem   = any_entry_has(BENCH_ENTRY_MEM);
+            layout.spark = ranked_sparklines && sparkline_range(&layout.spark_lo, &layout.spark_hi) == 0;
+            layout.tma   = any_entry_has(BENCH_ENTRY_TMA);
+            layout.throttle = any_entry_has(BENCH_ENTRY_THROTTLED);
+            for (size_t i = 0; i < benchmarks.timing_index && !layout.norm; i++)
+                layout.norm = ref_label_kind(benchmarks.timings[i].function_name) >= 0;
+
+            print_ranked_rule(&layout);
+            fprintf(stdout, "%s| %-20s | %-12s | %-7s |", BRIGHT_CYAN, "Function", "Exec Time", "% of total runtime");
+            if (layout.mem)
+                fprintf(stdout, " %-11s | %-11s | %-6s |", "RSS delta", "Peak RSS", "Frag");
+            if (layout.spark)
+                fprintf(stdout, " %-*s |", SPARKLINE_WIDTH, "Distribution");
+            if (layout.tma)
+                fprintf(stdout, " %-*s |", TMA_BAR_WIDTH, "Top-down");
+            if (layout.norm)
+                fprintf(stdout, " %-12s |", "Normalized");
+            if (layout.throttle)
+                fprintf(stdout, " %-12s |", "Throttled");
+            fprintf(stdout, "%s\n", RESET);
+            print_ranked_rule(&layout);
+
+            long long total    = ranked_total_time();
+            long long max_time = 0;
+            for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                const time_info *t = &benchmarks.timings[i];
+                if (!(t->flags & BENCH_ENTRY_MISMATCH) && t->time_us > max_time)
+                    max_time = t->time_us;
+            }
+
+            // Valid entries first, variants with wrong output listed after the ranking
+            for (int pass = 0; pass < 2; pass++) {
+                for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                    const time_info *t = &benchmarks.timings[i];
+                    if (((t->flags & BENCH_ENTRY_MISMATCH) != 0) == pass)
+                        print_ranked_row(t, total, max_time, &layout);
+                }
+            }
+
+            print_ranked_rule(&layout);
+            if (layout.spark)
+                print_sparkline_legend(layout.spark_lo, layout.spark_hi);
+            if (layout.tma)
+                print_tma_legend();
+            if (layout.norm)
+                print_ref_legend();
+            if (layout.throttle)
+                print_cgroup_legend();
+            print_ftrace_overhead();
+        }
+
+        void print_bench_json(void) {
+            long long total = ranked_total_time();
+            fprintf(stdout, ">>>{\n");
+            for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                const time_info *t = &benchmarks.timings[i];
+                double percentage = (!(t->flags & BENCH_ENTRY_MISMATCH) && total > 0)
+                                  ? (double)t->time_us * 100.0 / total : 0.0;
+                fprintf(stdout, "  \"%s\": {\"time_μs\": %lld, \"percentage\": %.2f",
+                        t->function_name,
+                        (long long)t->time_us,
+                        percentage);
+                if (t->flags & BENCH_ENTRY_MEM) {
+                    fprintf(stdout, ", \"rss_delta_bytes\": %lld, \"heap_delta_bytes\": %lld, "
+                                    "\"peak_rss_bytes\": %zu, \"fragmentation\": %.4f",
+                            t->rss_delta, t->heap_delta, t->peak_rss, t->fragmentation);
+                }
+                if (t->flags & BENCH_ENTRY_CHECKED)
+                    fprintf(stdout, ", \"output_valid\": %s", (t->flags & BENCH_ENTRY_MISMATCH) ? "false" : "true");
+                if (t->flags & BENCH_ENTRY_TMA) {
+                    const char *sep = "";
+                    fprintf(stdout, ", \"top_down\": {");
+                    for (int c = 0; c < BENCH_TMA_COUNT; c++) {
+                        if (t->tma_mask & (1u << c)) {
+                            fprintf(stdout, "%s\"%s\": %.4f", sep, tma_keys[c], t->tma[c]);
+                            sep = ", ";
+                        }
+                    }
+                    fprintf(stdout, "}");
+                }
+                if (t->flags & BENCH_ENTRY_THROTTLED)
+                    fprintf(stdout, ", \"throttled_μs\": %lld, \"throttle_periods\": %u", t->throttled_us, t->throttle_periods);
+                int ref = ref_label_kind(t->function_name);
+                if (ref >= 0) {
+                    double pass_us = bench_reference_score((bench_ref_kind)ref);
+                    fprintf(stdout, ", \"reference\": \"%s\", \"reference_μs\": %.3f, \"normalized\": %.4f",
+                            bench_reference_name((bench_ref_kind)ref), pass_us, (double)t->time_us / pass_us);
+                }
+                fprintf(stdout, "}%s\n", (i < benchmarks.timing_index - 1) ? "," : "");
+            }
+            fprintf(stdout, "}<<<\n");
+        }
+
+        void print_bench(void) {
+            for (size_t i = 0; i < benchmarks.timing_index; i++) {
+                fprintf(stdout, "%s:%lld\n", benchmarks.timings[i].function_name, benchmarks.timings[i].time_us);
+            }
+        }
+
+        // ─── Memory Snapshots ─────────────────────────────────────────────────────
+
+        /** RSS from /proc/self/statm only; unlike bench_mem_sample() it never takes malloc's locks. */
+        static size_t read_rss_bytes(void) {
+        #if defined(__linux__)
+            char buf[128];
+            int fd = open("/proc/self/statm", O_RDONLY);
+            if (fd < 0)
+                return 0;
+            ssize_t n = read(fd, buf, sizeof(buf) - 1);
+            close(fd);
+            if (n <= 0)
+                return 0;
+            buf[n] = '\0';
+            unsigned long long size_pages = 0, resident_pages = 0;
+            if (sscanf(buf, "%llu %llu", &size_pages, &resident_pages) != 2)
+                return 0;
+            return (size_t)resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+        #else
+            return 0;
+        #endif
+        }
+
+        int bench_mem_sample(bench_mem_snapshot_t *snap) {
+            memset(snap, 0, sizeof(*snap));
+
+        #if defined(BENCH_HAVE_MALLINFO2)
+            struct mallinfo2 mi = mallinfo2();
+            snap->heap_in_use = mi.uordblks + mi.hblkhd;
+            snap->heap_free   = mi.fordblks;
+            snap->heap_arena  = mi.arena + mi.hblkhd;
+            snap->heap_top    = mi.keepcost;
+        #endif
+
+            // Raw read(): stdio would allocate and disturb the heap figures above.
+            snap->rss_bytes = read_rss_bytes();
+            return snap->rss_bytes ? 0 : -1;
+        }
+
+        double bench_mem_fragmentation(const bench_mem_snapshot_t *snap) {
+            if (snap->heap_arena == 0 || snap->heap_free < snap->heap_top)
+                return 0.0;
+            return (double)(snap->heap_free - snap->heap_top) / (double)snap->heap_arena;
+        }
+
+        static struct {
+            bench_mem_snapshot_t begin;         /**< Snapshot at region entry */
+            size_t               peak_rss;      /**< Running peak, updated by the sampler */
+            int                  region_active; /**< Sampler only polls inside regions */
+            int                  sampler_stop;
+            unsigned             interval_ms;
+            pthread_t            sampler;
+            int                  sampler_running;
+            int                  hwm_valid;     /**< VmHWM was reset at region entry */
+        } mem_state;
+
+        /** Resets the kernel's RSS high-water mark (VmHWM) to the current RSS. */
+        static int hwm_reset(void) {
+            int fd = open("/proc/self/clear_refs", O_WRONLY);
+            if (fd < 0)
+                return -1;
+            int ok = write(fd, "5", 1) == 1;
+            close(fd);
+            return ok ? 0 : -1;
+        }
+
+        /** VmHWM in bytes, -1 if unavailable (raw read, no allocation). */
+        static long long hwm_read(void) {
+            char buf[4096];
+            int fd = open("/proc/self/status", O_RDONLY);
+            if (fd < 0)
+                return -1;
+            ssize_t n = read(fd, buf, sizeof(buf) - 1);
+            close(fd);
+            if (n <= 0)
+                return -1;
+            buf[n] = '\0';
+            const char *hwm = strstr(buf, "VmHWM:");
+            return hwm ? atoll(hwm + 6) * 1024 : -1;
+        }
+
+        static void *mem_sampler_main(void *arg) {
+            (void)arg;
+            struct timespec period = {
+                (time_t)(mem_state.interval_ms / 1000),
+                (long)(mem_state.interval_ms % 1000) * 1000000L
+            };
+
+            while (!__atomic_load_n(&mem_state.sampler_stop, __ATOMIC_ACQUIRE)) {
+                if (__atomic_load_n(&mem_state.region_active, __ATOMIC_ACQUIRE)) {
+                    size_t rss  = read_rss_bytes();
+                    size_t peak = __atomic_load_n(&mem_state.peak_rss, __ATOMIC_RELAXED);
+                    while (rss > peak &&
+                           !__atomic_compare_exchange_n(&mem_state.peak_rss, &peak, rss, 0,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    }
+                }
+                nanosleep(&period, NULL);
+            }
+            return NULL;
+        }
+
+        int bench_mem_enable(int enabled, unsigned sampler_interval_ms) {
+            if (mem_state.sampler_running) {
+                __atomic_store_n(&mem_state.sampler_stop, 1, __ATOMIC_RELEASE);
+                pthread_join(mem_state.sampler, NULL);
+                mem_state.sampler_running = 0;
+            }
+
+            // One baseline and one running peak: only the enabling thread's regions are captured.
+            mem_owner = enabled;
+            if (!enabled || sampler_interval_ms == 0)
+                return 0;
+
+            mem_state.interval_ms  = sampler_interval_ms;
+            mem_state.sampler_stop = 0;
+            if (pthread_create(&mem_state.sampler, NULL, mem_sampler_main, NULL) != 0) {
+                fprintf(stderr, "Error: Could not start the peak-RSS sampler thread!\n");
+                return -1;
+            }
+            mem_state.sampler_running = 1;
+            return 0;
+        }
+
+        static void mem_region_begin(void) {
+            mem_state.hwm_valid = hwm_reset() == 0;
+            bench_mem_sample(&mem_state.begin);
+            __atomic_store_n(&mem_state.peak_rss, mem_state.begin.rss_bytes, __ATOMIC_RELAXED);
+            __atomic_store_n(&mem_state.region_active, 1, __ATOMIC_RELEASE);
+        }
+
+        static void mem_region_end(time_info *entry) {
+            __atomic_store_n(&mem_state.region_active, 0, __ATOMIC_RELEASE);
+
+            bench_mem_snapshot_t end;
+            bench_mem_sample(&end);
+
+            size_t peak = __atomic_load_n(&mem_state.peak_rss, __ATOMIC_RELAXED);
+            long long hwm = mem_state.hwm_valid ? hwm_read() : -1;
+            if (hwm > 0 && (size_t)hwm > peak)
+                peak = (size_t)hwm;   // catches peaks between sampler polls, or with no sampler
+            entry->flags        |= BENCH_ENTRY_MEM;
+            entry->rss_delta     = (long long)end.rss_bytes - (long long)mem_state.begin.rss_bytes;
+            entry->heap_delta    = (long long)end.heap_in_use - (long long)mem_state.begin.heap_in_use;
+            entry->peak_rss      = peak > end.rss_bytes ? peak : end.rss_bytes;
+            entry->fragmentation = bench_mem_fragmentation(&end);
+        }
+
+        // ─── Soak Mode ────────────────────────────────────────────────────────────
+
+        /**
+        * @brief Per-batch sums of one metric; batch k covers [k, k+1) * duration / SOAK_BATCHES.
+        */
+        typedef struct {
+            double duration_s;
+            size_t n[SOAK_BATCHES];
+            double sum_x[SOAK_BATCHES], sum_y[SOAK_BATCHES];
+        } bench_batches_t;
+
+        static void batches_add(bench_batches_t *b, double x, double y) {
+            int k = (int)(x / b->duration_s * SOAK_BATCHES);
+            if (k < 0) k = 0;
+            if (k >= SOAK_BATCHES) k = SOAK_BATCHES - 1;
+            b->n[k]++;
+            b->sum_x[k] += x;
+            b->sum_y[k] += y;
+        }
+
+        /** Two-sided 95% Student-t critical value (Cornish-Fisher expansion). */
+        static double t_critical_95(double df) {
+            const double z = 1.959963984540054;
+            if (df < 1.0)
+                return INFINITY;
+            double z3 = z * z * z, z5 = z3 * z * z;
+            return z + (z3 + z) / (4.0 * df) + (5.0 * z5 + 16.0 * z3 + 3.0 * z) / (96.0 * df * df);
+        }
+
+        /**
+        * Fit the slope (per hour, x in seconds) through the batch means and flag
+        * it if significant and its change over `elapsed_s` is >= threshold.
+        */
+        static bench_trend_t batches_trend(const bench_batches_t *b, double elapsed_s, double threshold) {
+            bench_trend_t t = { 0.0, 0.0, 0.0, 0.0, 0, 0 };
+            size_t samples = 0, m = 0;
+            double mean_x = 0.0, mean_y = 0.0, sxx = 0.0, syy = 0.0, sxy = 0.0, total = 0.0;
+            for (int k = 0; k < SOAK_BATCHES; k++) {
+                if (b->n[k] == 0)
+                    continue;
+                samples += b->n[k];
+                total   += b->sum_y[k];
+                double x = b->sum_x[k] / (double)b->n[k];
+                double y = b->sum_y[k] / (double)b->n[k];
+                m++;
+                double dx = x - mean_x, dy = y - mean_y;
+                mean_x += dx / (double)m;
+                mean_y += dy / (double)m;
+                sxx += dx * (x - mean_x);
+                syy += dy * (y - mean_y);
+                sxy += dx * (y - mean_y);
+            }
+            if (samples)
+                t.mean = total / (double)samples;
+            if (m < 3 || sxx <= 0.0)
+                return t;
+
+            double slope = sxy / sxx;
+            double sse   = syy - slope * sxy;
+            if (sse < 0.0)
+                sse = 0.0;
+            double se = sqrt(sse / (double)(m - 2) / sxx);
+
+            t.slope_per_hour = slope * 3600.0;
+            t.ci95_per_hour  = t_critical_95((double)(m - 2)) * se * 3600.0;
+            t.change         = slope * elapsed_s;
+            t.judged         = elapsed_s >= SOAK_MIN_VERDICT_S;
+            t.drifting       = t.judged && fabs(t.slope_per_hour) > t.ci95_per_hour &&
+                               fabs(t.change) >= threshold;
+            return t;
+        }
+
+        int bench_soak(const char *label, bench_fn fn, void *arg, double duration_s, bench_soak_report_t *report) {
+            if (!label || !fn || duration_s <= 0.0) {
+                fprintf(stderr, "Error: bench_soak() needs a label, a function and a positive duration!\n");
+                return -1;
+            }
+
+            bench_batches_t lat = {0}, rss = {0}, heap = {0}, frag = {0};
+            lat.duration_s = rss.duration_s = heap.duration_s = frag.duration_s = duration_s;
+            size_t  reps     = 0, mem_samples = 0;
+            int64_t total_ns = 0;
+
+            int64_t t0       = get_time_ns();
+            int64_t deadline = t0 + (int64_t)(duration_s * 1e9);
+            int64_t next_mem = t0;
+            int64_t now      = t0;
+
+            while (now < deadline) {
+                int64_t s = get_time_ns();
+                fn(arg);
+                now = get_time_ns();
+
+                batches_add(&lat, (double)(now - t0) * 1e-9, (double)(now - s));
+                total_ns += now - s;
+                reps++;
+
+                if (now >= next_mem) {
+                    bench_mem_snapshot_t snap;
+                    if (bench_mem_sample(&snap) == 0) {
+                        double x = (double)(now - t0) * 1e-9;
+                        batches_add(&rss, x, (double)snap.rss_bytes);
+                        mem_samples++;
+                        if (snap.heap_arena > 0) {
+                            batches_add(&heap, x, (double)snap.heap_in_use);
+                            batches_add(&frag, x, bench_mem_fragmentation(&snap));
+                        }
+                    }
+                    now      = get_time_ns();
+                    next_mem = now + (int64_t)SOAK_SAMPLE_INTERVAL_US * 1000;
+                }
+            }
+
+            double mean_ns = reps ? (double)total_ns / (double)reps : 0.0;
+            record_timing_us(label, (long long)llround(mean_ns * 1e-3));
+
+            if (report) {
+                memset(report, 0, sizeof(*report));
+                strncpy(report->label, label, sizeof(report->label) - 1);
+                report->repetitions   = reps;
+                report->mem_samples   = mem_samples;
+                report->elapsed_s     = (double)(now - t0) * 1e-9;
+                double elapsed        = report->elapsed_s;
+                report->latency_ns    = batches_trend(&lat, elapsed, mean_ns * SOAK_LATENCY_DRIFT_PCT / 100.0);
+                report->rss_bytes     = batches_trend(&rss, elapsed, SOAK_MEMORY_DRIFT_BYTES);
+                report->heap_bytes    = batches_trend(&heap, elapsed, SOAK_MEMORY_DRIFT_BYTES);
+                report->fragmentation = batches_trend(&frag, elapsed, SOAK_FRAG_DRIFT);
+            }
+            return 0;
+        }
+
+        /** Ratios (empty unit) print as percentages, everything else SI-scaled. */
+        static void format_soak_value(double v, char *out, const char *unit) {
+            if (unit[0] && v == 0.0)
+                snprintf(out, STRING_LENGTH, "0 %s", unit);
+            else if (unit[0])
+                format_scaled(v, out, STRING_LENGTH, unit);
+            else
+                snprintf(out, STRING_LENGTH, "%.2f%%", v * 100.0);
+        }
+
+        static void print_soak_trend(const char *icon, const char *name, const bench_trend_t *t,
+                                     double elapsed_s, double to_unit, const char *unit) {
+            char mean_str[STRING_LENGTH], change_str[STRING_LENGTH], slope_str[STRING_LENGTH], ci_str[STRING_LENGTH];
+            format_soak_value(t->mean * to_unit, mean_str, unit);
+            format_soak_value(t->change * to_unit, change_str, unit);
+            format_soak_value(t->slope_per_hour * to_unit, slope_str, unit);
+            format_soak_value(t->ci95_per_hour * to_unit, ci_str, unit);
+
+            const char *verdict = t->judged ? (t->drifting ? "DRIFTING" : "stable")
+                                            : (elapsed_s < SOAK_MIN_VERDICT_S ? "too short" : "no data");
+            fprintf(stdout, "%s  %s%-14s%s: %s%s%s  change %s%s%s over the run (%s/h ± %s/h)  %s%s%s\n",
+                    icon, BRIGHT_CYAN, name, RESET,
+                    BRIGHT_YELLOW, mean_str, RESET,
+                    t->drifting ? BRIGHT_RED : BRIGHT_GREEN, change_str, RESET, slope_str, ci_str,
+                    t->drifting ? BRIGHT_RED : (t->judged ? GREEN : YELLOW), verdict, RESET);
+        }
+
+        void print_bench_soak(const bench_soak_report_t *report) {
+            char elapsed_str[STRING_LENGTH];
+            format_scaled(report->elapsed_s, elapsed_str, STRING_LENGTH, "s");
+
+            fprintf(stdout, "%s%s%s", BAR_COLOR, line, RESET);
+            fprintf(stdout, "🔁  %sSoak          %s : %s%s%s (%zu reps, %zu memory samples over %s)\n",
+                    BRIGHT_CYAN, RESET, BRIGHT_YELLOW, report->label, RESET,
+                    report->repetitions, report->mem_samples, elapsed_str);
+            print_soak_trend("⏱️", "Latency", &report->latency_ns, report->elapsed_s, 1e-9, "s");
+            print_soak_trend("🧠", "RSS", &report->rss_bytes, report->elapsed_s, 1.0, "B");
+            print_soak_trend("📦", "Heap in use", &report->heap_bytes, report->elapsed_s, 1.0, "B");
+            print_soak_trend("🧩", "Fragmentation", &report->fragmentation, report->elapsed_s, 1.0, "");
+            fprintf(stdout, "%s%s%s\n\n", BAR_COLOR, line, RESET);
+        }
+
+        // ─── Raw Samples & Statistics Kernels ─────────────────────────────────────
+
+        static bench_samples_t sample_sets[MAX_SAMPLE_LABELS];
+
+        static bench_samples_t *find_samples(const char *label) {
+            for (size_t i = 0; i < sample_set_count; i++) {
+                if (strcmp(sample_sets[i].label, label) == 0)
+                    return &sample_sets[i];
+            }
+            return NULL;
+        }
+
+        int bench_keep_samples(const char *label) {
+            if (find_samples(label))
+                return 0;
+            if (sample_set_count >= MAX_SAMPLE_LABELS) {
+                fprintf(stderr, "Error: Exceeded maximum number of sampled labels!\n");
+                return -1;
+            }
+            bench_samples_t *set = &sample_sets[sample_set_count++];
+            memset(set, 0, sizeof(*set));
+            strncpy(set->label, label, sizeof(set->label) - 1);
+            set->min = INT64_MAX;
+            set->max = INT64_MIN;
+            return 0;
+        }
+
+        /** Algorithm L: draw the next W and how many items to skip after `index`. */
+        static void reservoir_advance(bench_samples_t *set, size_t index) {
+            set->skip_w *= exp(log(random_unit()) / (double)set->reservoir);
+            double skip = floor(log(random_unit()) / log1p(-set->skip_w));
+            set->skip_next = index + 1 + (skip < 1e18 ? (size_t)skip : (size_t)1e18);
+        }
+
+        int bench_keep_reservoir(const char *label, size_t k) {
+            if (k == 0 || bench_keep_samples(label) != 0)
+                return -1;
+
+            bench_samples_t *set = find_samples(label);
+            if (set->reservoir == k)
+                return 0;
+            if (set->reservoir && k > set->reservoir && set->seen > set->count) {
+                fprintf(stderr, "Error: Reservoir of '%s' already dropped samples and cannot grow!\n", label);
+                return -1;
+            }
+
+            if (!set->reservoir) {
+                // Kept sets only store durations; the reservoir keeps exact aggregates over all of them.
+                set->seen = set->count;
+                set->mean = set->m2 = 0.0;
+                for (size_t i = 0; i < set->count; i++) {
+                    double delta = (double)set->ns[i] - set->mean;
+                    set->mean += delta / (double)(i + 1);
+                    set->m2   += delta * ((double)set->ns[i] - set->mean);
+                    if (set->ns[i] < set->min) set->min = set->ns[i];
+                    if (set->ns[i] > set->max) set->max = set->ns[i];
+                }
+            }
+            // A partial Fisher-Yates shuffle keeps a uniform k-subset of what is stored.
+            for (size_t i = 0; i < k && i + 1 < set->count; i++) {
+                size_t  j   = i + (size_t)(bench_random() % (set->count - i));
+                int64_t tmp = set->ns[i];
+                set->ns[i]  = set->ns[j];
+                set->ns[j]  = tmp;
+            }
+
+            int64_t *slots = (int64_t*)realloc(set->ns, k * sizeof(int64_t));
+            if (!slots) {
+                fprintf(stderr, "Error: Out of memory for a %zu-sample reservoir!\n", k);
+                return -1;
+            }
+            set->ns        = slots;
+            set->capacity  = k;
+            set->count     = set->count < k ? set->count : k;
+            set->reservoir = k;
+
+            // Replay W over the durations already seen: the next replacement then falls where
+            // Algorithm L would have put it had the reservoir been in place from the start.
+            if (set->count == k) {
+                set->skip_w = 1.0;
+                reservoir_advance(set, k - 1);
+                while (set->skip_next < set->seen)
+                    reservoir_advance(set, set->skip_next);
+            }
+            return 0;
+        }
+
+        static void reservoir_append(bench_samples_t *set, int64_t ns) {
+            size_t index = set->seen - 1;
+            if (set->count < set->reservoir) {
+                set->ns[set->count++] = ns;
+                if (set->count == set->reservoir) {
+                    set->skip_w = 1.0;
+                    reservoir_advance(set, index);
+                }
+                return;
+            }
+            if (index == set->skip_next) {
+                set->ns[bench_random() % set->reservoir] = ns;
+                reservoir_advance(set, index);
+            }
+        }
+
+        static void samples_append(bench_samples_t *set, int64_t ns) {
+            if (set->reservoir) {
+                set->seen++;
+                double delta = (double)ns - set->mean;
+                set->mean += delta / (double)set->seen;
+                set->m2   += delta * ((double)ns - set->mean);
+                if (ns < set->min) set->min = ns;
+                if (ns > set->max) set->max = ns;
+                reservoir_append(set, ns);
+                return;
+            }
+
+            set->seen++;
+            if (set->count == set->capacity) {
+                size_t   capacity = set->capacity ? set->capacity * 2 : 1024;
+                int64_t *grown    = (int64_t*)realloc(set->ns, capacity * sizeof(int64_t));
+                if (!grown) {
+                    fprintf(stderr, "Error: Out of memory for samples of '%s'!\n", set->label);
+                    return;
+                }
+                set->ns       = grown;
+                set->capacity = capacity;
+            }
+            set->ns[set->count++] = ns;
+        }
+
+        static void bench_record_sample_entry(const char *label, int64_t ns) {
+            bench_samples_t *set = find_samples(label);
+            if (set)
+                samples_append(set, ns);
+        }
+
+        void bench_record_sample(const char *label, int64_t ns) {
+            bench_samples_t *set = find_samples(label);
+            if (set)
+                samples_append(set, ns);
+        }
+
+        const bench_samples_t *bench_get_samples(const char *label) {
+            return find_samples(label);
+        }
+
+        static void samples_reset(void) {
+            for (size_t i = 0; i < sample_set_count; i++)
+                free(sample_sets[i].ns);
+            sample_set_count = 0;
+        }
+
+        /**
+        * Kernels work on `x - shift` converted to double with the 0x1.8p52
+        * trick, which is exact for |x - shift| < 2^51 (26 days in ns). Every
+        * vector kernel OR-accumulates `x - shift + 2^51` and reports failure
+        * if any value was out of range, in which case the scalar kernel reruns.
+        */
+        typedef struct {
+            int64_t min, max;         /**< Shifted extremes */
+            int64_t sum;              /**< Shifted sum */
+            double  sum_sq;           /**< Sum of squared shifted values */
+        } stats_acc_t;
+
+        #define BENCH_MAGIC_I   0x4338000000000000LL   /**< Bit pattern of 0x1.8p52 */
+        #define BENCH_MAGIC_D   6755399441055744.0     /**< 0x1.8p52 */
+        #define BENCH_BIAS_51   (1LL << 51)
+
+        static void stats_scalar(const int64_t *v, size_t n, int64_t shift, stats_acc_t *a) {
+            for (size_t i = 0; i < n; i++) {
+                int64_t d = v[i] - shift;
+                if (d < a->min) a->min = d;
+                if (d > a->max) a->max = d;
+                a->sum    += d;
+                a->sum_sq += (double)d * (double)d;
+            }
+        }
+
+        static size_t count_above_scalar(const int64_t *v, size_t n, int64_t threshold) {
+            size_t c = 0;
+            for (size_t i = 0; i < n; i++)
+                c += v[i] > threshold;
+            return c;
+        }
+
+        static void histogram_scalar(const int64_t *v, size_t n, int64_t lo, double inv_width,
+                                     size_t bins, uint64_t *counts) {
+            for (size_t i = 0; i < n; i++) {
+                double b = (double)(v[i] - lo) * inv_width;
+                size_t k = b <= 0.0 ? 0 : (b >= (double)(bins - 1) ? bins - 1 : (size_t)b);
+                counts[k]++;
+            }
+        }
+
+        #if defined(__x86_64__) && defined(__GNUC__)
+            #define BENCH_HAVE_SIMD_X86 1
+
+            // ── SSE2 ──
+
+            static int stats_sse2(const int64_t *v, size_t n, int64_t shift, stats_acc_t *a) {
+                const __m128i vshift  = _mm_set1_epi64x(shift);
+                const __m128i bias    = _mm_set1_epi64x(BENCH_BIAS_51);
+                const __m128i magic_i = _mm_set1_epi64x(BENCH_MAGIC_I);
+                const __m128d magic_d = _mm_set1_pd(BENCH_MAGIC_D);
+                __m128i range = _mm_setzero_si128(), sum = _mm_setzero_si128();
+                __m128d sq = _mm_setzero_pd(), mn = _mm_set1_pd(INFINITY), mx = _mm_set1_pd(-INFINITY);
+
+                size_t i = 0;
+                for (; i + 2 <= n; i += 2) {
+                    __m128i x = _mm_sub_epi64(_mm_loadu_si128((const __m128i*)(v + i)), vshift);
+                    range = _mm_or_si128(range, _mm_add_epi64(x, bias));
+                    sum   = _mm_add_epi64(sum, x);
+                    __m128d d = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(x, magic_i)), magic_d);
+                    mn = _mm_min_pd(mn, d);
+                    mx = _mm_max_pd(mx, d);
+                    sq = _mm_add_pd(sq, _mm_mul_pd(d, d));
+                }
+
+                int64_t r[2], s[2];
+                double  lo[2], hi[2], q[2];
+                _mm_storeu_si128((__m128i*)r, range);
+                _mm_storeu_si128((__m128i*)s, sum);
+                _mm_storeu_pd(lo, mn);
+                _mm_storeu_pd(hi, mx);
+                _mm_storeu_pd(q, sq);
+                if (((uint64_t)(r[0] | r[1])) >> 52)
+                    return -1;
+
+                if (i > 0) {
+                    a->min    = (int64_t)fmin(lo[0], lo[1]);
+                    a->max    = (int64_t)fmax(hi[0], hi[1]);
+                    a->sum    = s[0] + s[1];
+                    a->sum_sq = q[0] + q[1];
+                }
+                stats_scalar(v + i, n - i, shift, a);
+                return 0;
+            }
+
+            static int count_above_sse2(const int64_t *v, size_t n, int64_t threshold, size_t *out) {
+                const __m128i vshift  = _mm_set1_epi64x(threshold);
+                const __m128i bias    = _mm_set1_epi64x(BENCH_BIAS_51);
+                const __m128i magic_i = _mm_set1_epi64x(BENCH_MAGIC_I);
+                const __m128d magic_d = _mm_set1_pd(BENCH_MAGIC_D);
+                __m128i range = _mm_setzero_si128(), acc = _mm_setzero_si128();
+                size_t  i = 0;
+
+                // Compare masks are all-ones (-1), so subtracting them counts hits.
+                for (; i + 2 <= n; i += 2) {
+                    __m128i x = _mm_sub_epi64(_mm_loadu_si128((const __m128i*)(v + i)), vshift);
+                    range = _mm_or_si128(range, _mm_add_epi64(x, bias));
+                    __m128d d = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(x, magic_i)), magic_d);
+                    acc = _mm_sub_epi64(acc, _mm_castpd_si128(_mm_cmpgt_pd(d, _mm_setzero_pd())));
+                }
+
+                int64_t r[2], c[2];
+                _mm_storeu_si128((__m128i*)r, range);
+                _mm_storeu_si128((__m128i*)c, acc);
+                if (((uint64_t)(r[0] | r[1])) >> 52)
+                    return -1;
+                *out = (size_t)(c[0] + c[1]) + count_above_scalar(v + i, n - i, threshold);
+                return 0;
+            }
+
+            static int histogram_sse2(const int64_t *v, size_t n, int64_t lo, double inv_width,
+                                      size_t bins, uint64_t *counts) {
+                const __m128i vshift  = _mm_set1_epi64x(lo);
+                const __m128i bias    = _mm_set1_epi64x(BENCH_BIAS_51);
+                const __m128i magic_i = _mm_set1_epi64x(BENCH_MAGIC_I);
+                const __m128d magic_d = _mm_set1_pd(BENCH_MAGIC_D);
+                const __m128d vinv    = _mm_set1_pd(inv_width);
+                const __m128d vtop    = _mm_set1_pd((double)(bins - 1));
+                __m128i range = _mm_setzero_si128();
+                int32_t idx[4];
+                size_t  i = 0;
+
+                for (; i + 2 <= n; i += 2) {
+                    __m128i x = _mm_sub_epi64(_mm_loadu_si128((const __m128i*)(v + i)), vshift);
+                    range = _mm_or_si128(range, _mm_add_epi64(x, bias));
+                    __m128d d = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(x, magic_i)), magic_d);
+                    __m128d b = _mm_min_pd(_mm_max_pd(_mm_mul_pd(d, vinv), _mm_setzero_pd()), vtop);
+                    _mm_storeu_si128((__m128i*)idx, _mm_cvttpd_epi32(b));
+                    counts[idx[0]]++;
+                    counts[bins + idx[1]]++;
+                }
+
+                int64_t r[2];
+                _mm_storeu_si128((__m128i*)r, range);
+                if (((uint64_t)(r[0] | r[1])) >> 52)
+                    return -1;
+                histogram_scalar(v + i, n - i, lo, inv_width, bins, counts);
+                return 0;
+            }
+
+            // ── AVX2 ──
+
+            __attribute__((target("avx2")))
+            static int stats_avx2(const int64_t *v, size_t n, int64_t shift, stats_acc_t *a) {
+                const __m256i vshift  = _mm256_set1_epi64x(shift);
+                const __m256i bias    = _mm256_set1_epi64x(BENCH_BIAS_51);
+                const __m256i magic_i = _mm256_set1_epi64x(BENCH_MAGIC_I);
+                const __m256d magic_d = _mm256_set1_pd(BENCH_MAGIC_D);
+                __m256i range = _mm256_setzero_si256(), sum = _mm256_setzero_si256();
+                __m256d sq0 = _mm256_setzero_pd(), sq1 = _mm256_setzero_pd();
+                __m256d mn = _mm256_set1_pd(INFINITY), mx = _mm256_set1_pd(-INFINITY);
+
+                size_t i = 0;
+                for (; i + 8 <= n; i += 8) {
+                    __m256i x0 = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(v + i)), vshift);
+                    __m256i x1 = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(v + i + 4)), vshift);
+                    range = _mm256_or_si256(range, _mm256_or_si256(_mm256_add_epi64(x0, bias), _mm256_add_epi64(x1, bias)));
+                    sum   = _mm256_add_epi64(sum, _mm256_add_epi64(x0, x1));
+                    __m256d d0 = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x0, magic_i)), magic_d);
+                    __m256d d1 = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x1, magic_i)), magic_d);
+                    mn  = _mm256_min_pd(mn, _mm256_min_pd(d0, d1));
+                    mx  = _mm256_max_pd(mx, _mm256_max_pd(d0, d1));
+                    sq0 = _mm256_add_pd(sq0, _mm256_mul_pd(d0, d0));
+                    sq1 = _mm256_add_pd(sq1, _mm256_mul_pd(d1, d1));
+                }
+
+                int64_t r[4], s[4];
+                double  lo[4], hi[4], q[4];
+                _mm256_storeu_si256((__m256i*)r, range);
+                _mm256_storeu_si256((__m256i*)s, sum);
+                _mm256_storeu_pd(lo, mn);
+                _mm256_storeu_pd(hi, mx);
+                _mm256_storeu_pd(q, _mm256_add_pd(sq0, sq1));
+                if (((uint64_t)(r[0] | r[1] | r[2] | r[3])) >> 52)
+                    return -1;
+
+                if (i > 0) {
+                    a->min    = (int64_t)fmin(fmin(lo[0], lo[1]), fmin(lo[2], lo[3]));
+                    a->max    = (int64_t)fmax(fmax(hi[0], hi[1]), fmax(hi[2], hi[3]));
+                    a->sum    = s[0] + s[1] + s[2] + s[3];
+                    a->sum_sq = (q[0] + q[1]) + (q[2] + q[3]);
+                }
+                stats_scalar(v + i, n - i, shift, a);
+                return 0;
+            }
+
+            __attribute__((target("avx2")))
+            static int count_above_avx2(const int64_t *v, size_t n, int64_t threshold, size_t *out) {
+                const __m256i t = _mm256_set1_epi64x(threshold);
+                __m256i acc = _mm256_setzero_si256();
+                size_t  i = 0;
+
+                // Compare masks are all-ones (-1), so subtracting them counts hits.
+                for (; i + 4 <= n; i += 4)
+                    acc = _mm256_sub_epi64(acc, _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(v + i)), t));
+
+                int64_t c[4];
+                _mm256_storeu_si256((__m256i*)c, acc);
+                *out = (size_t)(c[0] + c[1] + c[2] + c[3]) + count_above_scalar(v + i, n - i, threshold);
+                return 0;
+            }
+
+            __attribute__((target("avx2")))
+            static int histogram_avx2(const int64_t *v, size_t n, int64_t lo, double inv_width,
+                                      size_t bins, uint64_t *counts) {
+                const __m256i vshift  = _mm256_set1_epi64x(lo);
+                const __m256i bias    = _mm256_set1_epi64x(BENCH_BIAS_51);
+                const __m256i magic_i = _mm256_set1_epi64x(BENCH_MAGIC_I);
+                const __m256d magic_d = _mm256_set1_pd(BENCH_MAGIC_D);
+                const __m256d vinv    = _mm256_set1_pd(inv_width);
+                const __m256d vtop    = _mm256_set1_pd((double)(bins - 1));
+                __m256i range = _mm256_setzero_si256();
+                int32_t idx[4];
+                size_t  i = 0;
+
+                for (; i + 4 <= n; i += 4) {
+                    __m256i x = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)(v + i)), vshift);
+                    range = _mm256_or_si256(range, _mm256_add_epi64(x, bias));
+                    __m256d d = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, magic_i)), magic_d);
+                    __m256d b = _mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(d, vinv), _mm256_setzero_pd()), vtop);
+                    _mm_storeu_si128((__m128i*)idx, _mm256_cvttpd_epi32(b));
+                    counts[idx[0]]++;
+                    counts[bins + idx[1]]++;
+                    counts[2 * bins + idx[2]]++;
+                    counts[3 * bins + idx[3]]++;
+                }
+
+                int64_t r[4];
+                _mm256_storeu_si256((__m256i*)r, range);
+                if (((uint64_t)(r[0] | r[1] | r[2] | r[3])) >> 52)
+                    return -1;
+                histogram_scalar(v + i, n - i, lo, inv_width, bins, counts);
+                return 0;
+            }
+
+            // ── AVX-512 ──
+
+            __attribute__((target("avx512f")))
+            static int stats_avx512(const int64_t *v, size_t n, int64_t shift, stats_acc_t *a) {
+                const __m512i vshift = _mm512_set1_epi64(shift);
+                const __m512i magic_i = _mm512_set1_epi64(BENCH_MAGIC_I);
+                const __m512d magic_d = _mm512_set1_pd(BENCH_MAGIC_D);
+                __m512i sum = _mm512_setzero_si512();
+                __m512i mn  = _mm512_set1_epi64(INT64_MAX), mx = _mm512_set1_epi64(INT64_MIN);
+                __m512d sq0 = _mm512_setzero_pd(), sq1 = _mm512_setzero_pd();
+
+                size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    __m512i x0 = _mm512_sub_epi64(_mm512_loadu_si512(v + i), vshift);
+                    __m512i x1 = _mm512_sub_epi64(_mm512_loadu_si512(v + i + 8), vshift);
+                    sum = _mm512_add_epi64(sum, _mm512_add_epi64(x0, x1));
+                    mn  = _mm512_min_epi64(mn, _mm512_min_epi64(x0, x1));
+                    mx  = _mm512_max_epi64(mx, _mm512_max_epi64(x0, x1));
+                    __m512d d0 = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_add_epi64(x0, magic_i)), magic_d);
+                    __m512d d1 = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_add_epi64(x1, magic_i)), magic_d);
+                    sq0 = _mm512_add_pd(sq0, _mm512_mul_pd(d0, d0));
+                    sq1 = _mm512_add_pd(sq1, _mm512_mul_pd(d1, d1));
+                }
+
+                // Native 64-bit min/max make the range check a simple bound test.
+                if (i > 0) {
+                    int64_t lo = _mm512_reduce_min_epi64(mn), hi = _mm512_reduce_max_epi64(mx);
+                    if (lo < -BENCH_BIAS_51 || hi >= BENCH_BIAS_51)
+                        return -1;
+                    a->min    = lo;
+                    a->max    = hi;
+                    a->sum    = _mm512_reduce_add_epi64(sum);
+                    a->sum_sq = _mm512_reduce_add_pd(_mm512_add_pd(sq0, sq1));
+                }
+                stats_scalar(v + i, n - i, shift, a);
+                return 0;
+            }
+
+            __attribute__((target("avx512f")))
+            static int count_above_avx512(const int64_t *v, size_t n, int64_t threshold, size_t *out) {
+                const __m512i t = _mm512_set1_epi64(threshold);
+                size_t c = 0, i = 0;
+                for (; i + 8 <= n; i += 8)
+                    c += (size_t)__builtin_popcount(_mm512_cmpgt_epi64_mask(_mm512_loadu_si512(v + i), t));
+                *out = c + count_above_scalar(v + i, n - i, threshold);
+                return 0;
+            }
+
+            __attribute__((target("avx512f")))
+            static int histogram_avx512(const int64_t *v, size_t n, int64_t lo, double inv_width,
+                                        size_t bins, uint64_t *counts) {
+                const __m512i vshift  = _mm512_set1_epi64(lo);
+                const __m512i magic_i = _mm512_set1_epi64(BENCH_MAGIC_I);
+                const __m512d magic_d = _mm512_set1_pd(BENCH_MAGIC_D);
+                const __m512d vinv    = _mm512_set1_pd(inv_width);
+                const __m512d vtop    = _mm512_set1_pd((double)(bins - 1));
+                const __m512i vlo     = _mm512_set1_epi64(-BENCH_BIAS_51);
+                const __m512i vhi     = _mm512_set1_epi64(BENCH_BIAS_51 - 1);
+                __mmask8 out_of_range = 0;
+                int32_t  idx[8];
+                size_t   i = 0;
+
+                for (; i + 8 <= n; i += 8) {
+                    __m512i x = _mm512_sub_epi64(_mm512_loadu_si512(v + i), vshift);
+                    out_of_range |= _mm512_cmplt_epi64_mask(x, vlo) | _mm512_cmpgt_epi64_mask(x, vhi);
+                    __m512d d = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_add_epi64(x, magic_i)), magic_d);
+                    __m512d b = _mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(d, vinv), _mm512_setzero_pd()), vtop);
+                    _mm256_storeu_si256((__m256i*)idx, _mm512_cvttpd_epi32(b));
+                    for (int k = 0; k < 8; k++)
+                        counts[(size_t)(k & 3) * bins + idx[k]]++;
+                }
+
+                if (out_of_range)
+                    return -1;
+                histogram_scalar(v + i, n - i, lo, inv_width, bins, counts);
+                return 0;
+            }
+        #endif
+
+        static bench_simd_level simd_level = BENCH_SIMD_SCALAR;
+        static int              simd_ready;
+
+        static bench_simd_level simd_detect(void) {
+        #if defined(BENCH_HAVE_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return BENCH_SIMD_AVX512;
+            if (__builtin_cpu_supports("avx2"))
+                return BENCH_SIMD_AVX2;
+            return BENCH_SIMD_SSE2;
+        #else
+            return BENCH_SIMD_SCALAR;
+        #endif
+        }
+
+        static bench_simd_level simd_current(void) {
+            if (!simd_ready) {
+                simd_level = simd_detect();
+                simd_ready = 1;
+            }
+            return simd_level;
+        }
+
+        bench_simd_level bench_simd_set(bench_simd_level level) {
+            bench_simd_level best = simd_detect();
+            simd_level = level < best ? level : best;
+            simd_ready = 1;
+            return simd_level;
+        }
+
+        const char *bench_simd_name(bench_simd_level level) {
+            switch (level) {
+                case BENCH_SIMD_SSE2:   return "sse2";
+                case BENCH_SIMD_AVX2:   return "avx2";
+                case BENCH_SIMD_AVX512: return "avx512";
+                default:                return "scalar";
+            }
+        }
+
+        void bench_stats_compute(const int64_t *v, size_t n, bench_stats_t *out) {
+            memset(out, 0, sizeof(*out));
+            if (n == 0)
+                return;
+
+            // Shifting by the first sample keeps the squares small and exact.
+            int64_t     shift = v[0];
+            stats_acc_t a     = { INT64_MAX, INT64_MIN, 0, 0.0 };
+            int         rc    = -1;
+
+        #if defined(BENCH_HAVE_SIMD_X86)
+            switch (simd_current()) {
+                case BENCH_SIMD_AVX512: rc = stats_avx512(v, n, shift, &a); break;
+                case BENCH_SIMD_AVX2:   rc = stats_avx2(v, n, shift, &a);   break;
+                case BENCH_SIMD_SSE2:   rc = stats_sse2(v, n, shift, &a);   break;
+                default: break;
+            }
+        #endif
+            if (rc != 0) {
+                a = (stats_acc_t){ INT64_MAX, INT64_MIN, 0, 0.0 };
+                stats_scalar(v, n, shift, &a);
+            }
+
+            double shifted_mean = (double)a.sum / (double)n;
+            out->count  = n;
+            out->min    = a.min + shift;
+            out->max    = a.max + shift;
+            out->mean   = shifted_mean + (double)shift;
+            out->sum    = out->mean * (double)n;
+            out->sum_sq = a.sum_sq - (double)n * shifted_mean * shifted_mean;
+            if (out->sum_sq < 0.0)
+                out->sum_sq = 0.0;
+            out->stddev = n > 1 ? sqrt(out->sum_sq / (double)(n - 1)) : 0.0;
+        }
+
+        size_t bench_count_above(const int64_t *v, size_t n, int64_t threshold) {
+            size_t c  = 0;
+            int    rc = -1;
+        #if defined(BENCH_HAVE_SIMD_X86)
+            switch (simd_current()) {
+                case BENCH_SIMD_AVX512: rc = count_above_avx512(v, n, threshold, &c); break;
+                case BENCH_SIMD_AVX2:   rc = count_above_avx2(v, n, threshold, &c);   break;
+                case BENCH_SIMD_SSE2:   rc = count_above_sse2(v, n, threshold, &c);   break;
+                default: break;
+            }
+        #endif
+            return rc == 0 ? c : count_above_scalar(v, n, threshold);
+        }
+
+        void bench_histogram(const int64_t *v, size_t n, int64_t lo, int64_t hi, size_t bins, uint64_t *counts) {
+            if (bins == 0 || n == 0)
+                return;
+            double inv_width = hi > lo ? (double)bins / (double)(hi - lo) : 0.0;
+
+            // Vector paths count into four interleaved sub-histograms (so that
+            // neighbouring lanes hitting the same bucket don't serialize on one
+            // counter) and merge at the end; a failed range check discards them.
+            uint64_t *scratch = NULL;
+            int       rc      = -1;
+        #if defined(BENCH_HAVE_SIMD_X86)
+            if (simd_current() != BENCH_SIMD_SCALAR && bins <= INT32_MAX)
+                scratch = (uint64_t*)calloc(4 * bins, sizeof(uint64_t));
+            if (scratch) {
+                switch (simd_current()) {
+                    case BENCH_SIMD_AVX512: rc = histogram_avx512(v, n, lo, inv_width, bins, scratch); break;
+                    case BENCH_SIMD_AVX2:   rc = histogram_avx2(v, n, lo, inv_width, bins, scratch);   break;
+                    default:                rc = histogram_sse2(v, n, lo, inv_width, bins, scratch);   break;
+                }
+                if (rc == 0) {
+                    for (size_t k = 0; k < bins; k++)
+                        counts[k] += scratch[k] + scratch[bins + k] + scratch[2 * bins + k] + scratch[3 * bins + k];
+                }
+                free(scratch);
+            }
+        #endif
+            if (rc != 0)
+                histogram_scalar(v, n, lo, inv_width, bins, counts);
+        }
+
+        // ─── Exact Quantiles ──────────────────────────────────────────────────────
+
+        static unsigned report_threads;
+
+        /**
+        * Report scratch arena: reserved once per report call, then bump-allocated.
+        * It is kept between calls so repeated reports don't hit the allocator.
+        */
+        static struct {
+            unsigned char *base;
+            size_t         size;
+            size_t         used;
+        } report_arena;
+
+        static int arena_reserve(size_t bytes) {
+            report_arena.used = 0;
+            if (bytes <= report_arena.size)
+                return 0;
+            free(report_arena.base);
+            report_arena.base = (unsigned char*)malloc(bytes);
+            report_arena.size = report_arena.base ? bytes : 0;
+            return report_arena.base ? 0 : -1;
+        }
+
+        static void *arena_alloc(size_t bytes) {
+            size_t offset = (report_arena.used + 63) & ~(size_t)63;
+            if (offset + bytes > report_arena.size)
+                return NULL;
+            report_arena.used = offset + bytes;
+            return report_arena.base + offset;
+        }
+
+        static void arena_release(void) {
+            free(report_arena.base);
+            memset(&report_arena, 0, sizeof(report_arena));
+        }
+
+        void bench_set_report_threads(unsigned threads) {
+            report_threads = threads;
+        }
+
+        unsigned bench_report_threads(void) {
+            if (report_threads)
+                return report_threads;
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            return cpus > 0 ? (unsigned)cpus : 1;
+        }
+
+        #define RADIX_BITS     8
+        #define RADIX_BUCKETS  (1 << RADIX_BITS)
+
+        typedef struct {
+            const uint64_t *src;
+            uint64_t       *dst;
+            size_t          begin, end;
+            unsigned        shift;
+            size_t         *counts;   /**< RADIX_BUCKETS counters, then offsets */
+        } radix_job_t;
+
+        static void *radix_count(void *arg) {
+            radix_job_t *j = (radix_job_t*)arg;
+            memset(j->counts, 0, RADIX_BUCKETS * sizeof(size_t));
+            for (size_t i = j->begin; i < j->end; i++)
+                j->counts[(j->src[i] >> j->shift) & (RADIX_BUCKETS - 1)]++;
+            return NULL;
+        }
+
+        static void *radix_scatter(void *arg) {
+            radix_job_t *j = (radix_job_t*)arg;
+            for (size_t i = j->begin; i < j->end; i++) {
+                uint64_t key = j->src[i];
+                j->dst[j->counts[(key >> j->shift) & (RADIX_BUCKETS - 1)]++] = key;
+            }
+            return NULL;
+        }
+
+        static void radix_parallel(void *(*fn)(void*), radix_job_t *jobs, unsigned threads, pthread_t *tids) {
+            unsigned started = 0;
+            for (unsigned t = 1; t < threads; t++) {
+                if (pthread_create(&tids[t], NULL, fn, &jobs[t]) != 0)
+                    break;
+                started = t;
+            }
+            // The calling thread takes chunk 0, plus any chunk a thread failed to start for.
+            fn(&jobs[0]);
+            for (unsigned t = started + 1; t < threads; t++)
+                fn(&jobs[t]);
+            for (unsigned t = 1; t <= started; t++)
+                pthread_join(tids[t], NULL);
+        }
+
+        /** Radix sort of sign-flipped keys in `keys`, using `tmp` (n slots) as the other buffer. */
+        static uint64_t *radix_sort_keys(uint64_t *keys, uint64_t *tmp, size_t n, unsigned threads,
+                                         radix_job_t *jobs, size_t *counts, pthread_t *tids) {
+            // Keys that agree on a whole byte need no pass for it.
+            uint64_t all_and = ~(uint64_t)0, all_or = 0;
+            for (size_t i = 0; i < n; i++) {
+                all_and &= keys[i];
+                all_or  |= keys[i];
+            }
+            uint64_t varying = all_and ^ all_or;
+
+            uint64_t *src = keys, *dst = tmp;
+            for (unsigned shift = 0; shift < 64; shift += RADIX_BITS) {
+                if (((varying >> shift) & (RADIX_BUCKETS - 1)) == 0)
+                    continue;
+
+                for (unsigned t = 0; t < threads; t++) {
+                    jobs[t].src    = src;
+                    jobs[t].dst    = dst;
+                    jobs[t].begin  = n * t / threads;
+                    jobs[t].end    = n * (t + 1) / threads;
+                    jobs[t].shift  = shift;
+                    jobs[t].counts = counts + (size_t)t * RADIX_BUCKETS;
+                }
+                radix_parallel(radix_count, jobs, threads, tids);
+
+                // Bucket-major, thread-minor prefix sums keep the sort stable.
+                size_t offset = 0;
+                for (unsigned b = 0; b < RADIX_BUCKETS; b++) {
+                    for (unsigned t = 0; t < threads; t++) {
+                        size_t c = jobs[t].counts[b];
+                        jobs[t].counts[b] = offset;
+                        offset += c;
+                    }
+                }
+                radix_parallel(radix_scatter, jobs, threads, tids);
+
+                uint64_t *swap = src;
+                src = dst;
+                dst = swap;
+            }
+            return src;
+        }
+
+        static unsigned radix_threads(size_t n) {
+            unsigned threads = n >= BENCH_RADIX_PARALLEL_MIN ? bench_report_threads() : 1;
+            return threads > 64 ? 64 : threads;
+        }
+
+        /** Arena bytes one sort of `n` keys needs, alignment padding included. */
+        static size_t radix_scratch_bytes(size_t n) {
+            return n * sizeof(uint64_t) + radix_threads(n) * (RADIX_BUCKETS * sizeof(size_t) +
+                   sizeof(radix_job_t) + sizeof(pthread_t)) + 4 * 64;
+        }
+
+        /** Sorts with scratch bump-allocated from the already reserved arena, and gives it back. */
+        static int sort_in_arena(int64_t *v, size_t n) {
+            if (n < 2)
+                return 0;
+
+            unsigned     threads = radix_threads(n);
+            size_t       mark    = report_arena.used;
+            uint64_t    *tmp     = (uint64_t*)arena_alloc(n * sizeof(uint64_t));
+            size_t      *counts  = (size_t*)arena_alloc(threads * RADIX_BUCKETS * sizeof(size_t));
+            radix_job_t *jobs    = (radix_job_t*)arena_alloc(threads * sizeof(radix_job_t));
+            pthread_t   *tids    = (pthread_t*)arena_alloc(threads * sizeof(pthread_t));
+            if (!tmp || !counts || !jobs || !tids) {
+                report_arena.used = mark;
+                return -1;
+            }
+
+            // Flipping the sign bit makes unsigned order match signed order.
+            uint64_t *keys = (uint64_t*)v;
+            for (size_t i = 0; i < n; i++)
+                keys[i] ^= (uint64_t)1 << 63;
+
+            uint64_t *sorted = radix_sort_keys(keys, tmp, n, threads, jobs, counts, tids);
+            if (sorted != keys)
+                memcpy(keys, sorted, n * sizeof(uint64_t));
+
+            for (size_t i = 0; i < n; i++)
+                keys[i] ^= (uint64_t)1 << 63;
+            report_arena.used = mark;
+            return 0;
+        }
+
+        int bench_sort_samples(int64_t *v, size_t n) {
+            if (n < 2)
+                return 0;
+            if (arena_reserve(radix_scratch_bytes(n)) != 0) {
+                fprintf(stderr, "Error: Out of memory for sorting %zu samples!\n", n);
+                return -1;
+            }
+            return sort_in_arena(v, n);
+        }
+
+        static void insertion_sort_i64(int64_t *a, size_t lo, size_t hi) {
+            for (size_t i = lo + 1; i < hi; i++) {
+                int64_t x = a[i];
+                size_t  j = i;
+                while (j > lo && a[j - 1] > x) {
+                    a[j] = a[j - 1];
+                    j--;
+                }
+                a[j] = x;
+            }
+        }
+
+        static int64_t median3_i64(int64_t a, int64_t b, int64_t c) {
+            if (a > b) { int64_t t = a; a = b; b = t; }
+            if (b > c) b = c;
+            return a > b ? a : b;
+        }
+
+        /**
+        * Place the k-th smallest element of a[lo, hi) at a[k], with smaller
+        * elements before it and larger ones after. Three-way partitioning keeps
+        * runs of equal durations cheap; a depth limit falls back to sorting.
+        */
+        static void select_kth(int64_t *a, size_t lo, size_t hi, size_t k) {
+            unsigned depth = 0;
+            while (hi - lo > 16) {
+                if (++depth > 64) {
+                    if (sort_in_arena(a + lo, hi - lo) != 0)
+                        insertion_sort_i64(a, lo, hi);
+                    return;
+                }
+
+                size_t  mid   = lo + (hi - lo) / 2;
+                int64_t pivot = median3_i64(a[lo], a[mid], a[hi - 1]);
+
+                size_t lt = lo, i = lo, gt = hi;
+                while (i < gt) {
+                    if (a[i] < pivot) {
+                        int64_t t = a[lt]; a[lt++] = a[i]; a[i++] = t;
+                    } else if (a[i] > pivot) {
+                        int64_t t = a[--gt]; a[gt] = a[i]; a[i] = t;
+                    } else {
+                        i++;
+                    }
+                }
+
+                if (k < lt)
+                    hi = lt;
+                else if (k >= gt)
+                    lo = gt;
+                else
+                    return;
+            }
+            insertion_sort_i64(a, lo, hi);
+        }
+
+        static size_t quantile_rank(double q, size_t n) {
+            if (q <= 0.0)
+                return 0;
+            double r = ceil(q * (double)n);
+            if (r <= 1.0)
+                return 0;
+            return r >= (double)n ? n - 1 : (size_t)r - 1;
+        }
+
+        int bench_quantiles(const int64_t *v, size_t n, const double *q, size_t nq, int64_t *out) {
+            if (n == 0 || nq == 0)
+                return -1;
+
+            // The copy and any sort scratch share one arena reservation.
+            if (arena_reserve(n * sizeof(int64_t) + 64 + radix_scratch_bytes(n)) != 0) {
+                fprintf(stderr, "Error: Out of memory for quantiles of %zu samples!\n", n);
+                return -1;
+            }
+            int64_t *copy = (int64_t*)arena_alloc(n * sizeof(int64_t));
+            memcpy(copy, v, n * sizeof(int64_t));
+
+            if (nq > BENCH_SELECT_MAX_QUANTILES) {
+                if (sort_in_arena(copy, n) != 0)
+                    return -1;
+                for (size_t i = 0; i < nq; i++)
+                    out[i] = copy[quantile_rank(q[i], n)];
+                return 0;
+            }
+
+            // Select ranks in ascending order; each selection narrows the next.
+            size_t ranks[BENCH_SELECT_MAX_QUANTILES], order[BENCH_SELECT_MAX_QUANTILES];
+            for (size_t i = 0; i < nq; i++) {
+                ranks[i] = quantile_rank(q[i], n);
+                order[i] = i;
+            }
+            for (size_t i = 1; i < nq; i++) {
+                size_t o = order[i], j = i;
+                while (j > 0 && ranks[order[j - 1]] > ranks[o]) {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+                order[j] = o;
+            }
+
+            size_t lo = 0;
+            for (size_t i = 0; i < nq; i++) {
+                size_t k = ranks[order[i]];
+                select_kth(copy, lo, n, k);
+                out[order[i]] = copy[k];
+                lo = k;
+            }
+            return 0;
+        }
+
+        /** Exact statistics: running aggregates for reservoirs, kernels over full arrays. */
+        static void samples_stats(const bench_samples_t *set, bench_stats_t *st) {
+            if (!set->reservoir) {
+                bench_stats_compute(set->ns, set->count, st);
+                return;
+            }
+            memset(st, 0, sizeof(*st));
+            if (set->seen == 0)
+                return;
+            st->count  = set->seen;
+            st->min    = set->min;
+            st->max    = set->max;
+            st->mean   = set->mean;
+            st->sum    = set->mean * (double)set->seen;
+            st->sum_sq = set->m2;
+            st->stddev = set->seen > 1 ? sqrt(set->m2 / (double)(set->seen - 1)) : 0.0;
+        }
+
+        void print_bench_samples(void) {
+            if (sample_set_count == 0) {
+                fprintf(stdout, "\nNo raw samples retained.\n");
+                return;
+            }
+
+            static const double quantiles[] = { 0.50, 0.99, 0.999 };
+            const char *rule = "------------------------------------------------------------------------------------------"
+                               "-------------------------------------------------------";
+
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-20s | %10s | %10s | %11s | %11s | %11s | %11s | %11s | %11s | %11s |%s\n", BRIGHT_CYAN,
+                    "Function", "Samples", "Kept", "Mean", "Std dev", "Min", "p50", "p99", "p99.9", "Max", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (size_t i = 0; i < sample_set_count; i++) {
+                const bench_samples_t *set = &sample_sets[i];
+                bench_stats_t st;
+                samples_stats(set, &st);
+
+                int64_t q[3] = { 0, 0, 0 };
+                bench_quantiles(set->ns, set->count, quantiles, 3, q);
+
+                double values[7] = { st.mean, st.stddev, (double)st.min, (double)q[0], (double)q[1], (double)q[2], (double)st.max };
+                char   strs[7][STRING_LENGTH];
+                for (int k = 0; k < 7; k++)
+                    format_scaled(values[k] * 1e-9, strs[k], STRING_LENGTH, "s");
+
+                fprintf(stdout, "| %-20s | %10zu | %10zu | %11s | %11s | %11s | %11s | %11s | %11s | %11s |\n",
+                        set->label, st.count, set->count, strs[0], strs[1], strs[2], strs[3], strs[4], strs[5], strs[6]);
+            }
+
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%sstatistics kernels: %s, report threads: %u%s\n",
+                    BRIGHT_CYAN, bench_simd_name(simd_current()), bench_report_threads(), RESET);
+            for (size_t i = 0; i < sample_set_count; i++) {
+                if (sample_sets[i].throttled)
+                    fprintf(stdout, "%s%s: %zu of %zu regions overlapped cgroup throttling%s\n", BRIGHT_RED,
+                            sample_sets[i].label, sample_sets[i].throttled, sample_sets[i].seen, RESET);
+            }
+        }
+
+        void bench_ranked_sparklines(int enabled) {
+            ranked_sparklines = enabled;
+        }
+
+        static int sparkline_range(int64_t *lo, int64_t *hi) {
+            *lo = INT64_MAX;
+            *hi = INT64_MIN;
+            for (size_t i = 0; i < sample_set_count; i++) {
+                bench_stats_t st;
+                samples_stats(&sample_sets[i], &st);
+                if (st.count == 0)
+                    continue;
+                if (st.min < *lo) *lo = st.min;
+                if (st.max > *hi) *hi = st.max;
+            }
+            if (*lo > *hi)
+                return -1;
+            if (*lo < 1)
+                *lo = 1;
+            if (*hi <= *lo)
+                *hi = *lo + 1;
+            return 0;
+        }
+
+        /** Bucket of `x` among SPARKLINE_WIDTH log-spaced buckets with the given inner edges. */
+        static int sparkline_bucket(const double *edges, int64_t x) {
+            int a = 0, b = SPARKLINE_WIDTH - 1;
+            while (a < b) {
+                int m = (a + b) / 2;
+                if ((double)x < edges[m])
+                    b = m;
+                else
+                    a = m + 1;
+            }
+            return a;
+        }
+
+        static void print_sparkline(const char *label, int64_t lo, int64_t hi) {
+            static const char *levels[] = { " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+            const bench_samples_t *set = find_samples(label);
+            if (!set || set->count == 0) {
+                fprintf(stdout, "%*s", SPARKLINE_WIDTH, "");
+                return;
+            }
+
+            // Edge k separates bucket k from k + 1 (binary search beats log() per sample).
+            double edges[SPARKLINE_WIDTH];
+            double ratio = log((double)hi / (double)lo);
+            for (int k = 0; k < SPARKLINE_WIDTH; k++)
+                edges[k] = (double)lo * exp(ratio * (double)(k + 1) / SPARKLINE_WIDTH);
+
+            size_t counts[SPARKLINE_WIDTH] = { 0 };
+            size_t peak = 0;
+            for (size_t i = 0; i < set->count; i++)
+                counts[sparkline_bucket(edges, set->ns[i])]++;
+            for (int k = 0; k < SPARKLINE_WIDTH; k++)
+                if (counts[k] > peak) peak = counts[k];
+
+            static const double marks[] = { 0.50, 0.99 };
+            int64_t q[2] = { 0, 0 };
+            bench_quantiles(set->ns, set->count, marks, 2, q);
+            int median_bucket = sparkline_bucket(edges, q[0]);
+            int p99_bucket    = sparkline_bucket(edges, q[1]);
+
+            for (int k = 0; k < SPARKLINE_WIDTH; k++) {
+                // Any non-empty bucket gets at least the lowest block so that rare tails stay visible.
+                int level = counts[k] == 0 ? 0 : 1 + (int)((double)counts[k] * 7.0 / (double)peak);
+                const char *color = k == median_bucket ? BRIGHT_GREEN : (k == p99_bucket ? BRIGHT_RED : RESET);
+                fprintf(stdout, "%s%s", color, levels[level > 8 ? 8 : level]);
+            }
+            fprintf(stdout, "%s", RESET);
+        }
+
+        static void print_sparkline_legend(int64_t lo, int64_t hi) {
+            char lo_str[STRING_LENGTH], hi_str[STRING_LENGTH];
+            format_scaled((double)lo * 1e-9, lo_str, STRING_LENGTH, "s");
+            format_scaled((double)hi * 1e-9, hi_str, STRING_LENGTH, "s");
+            fprintf(stdout, "%sDistribution: log scale %s .. %s, %smedian%s%s, %sp99%s\n",
+                    BRIGHT_CYAN, lo_str, hi_str, BRIGHT_GREEN, RESET, BRIGHT_CYAN, BRIGHT_RED, RESET);
+        }
+
+        // ─── Runner & Output Validation ───────────────────────────────────────────
+
+        typedef struct {
+            char            name[MAX_FUNS_NAME_LENGTH];
+            double          rel_tol;
+            bench_digest_t *reference;       /**< Per-iteration digests of the first variant */
+            size_t          reference_count;
+        } check_group_t;
+
+        static check_group_t check_groups[MAX_CHECK_GROUPS];
+        static size_t        check_group_count;
+
+        static check_group_t *find_check_group(const char *name) {
+            for (size_t i = 0; i < check_group_count; i++) {
+                if (strcmp(check_groups[i].name, name) == 0)
+                    return &check_groups[i];
+            }
+            if (check_group_count >= MAX_CHECK_GROUPS) {
+                fprintf(stderr, "Error: Exceeded maximum number of comparison groups!\n");
+                return NULL;
+            }
+            check_group_t *g = &check_groups[check_group_count++];
+            memset(g, 0, sizeof(*g));
+            strncpy(g->name, name, sizeof(g->name) - 1);
+            return g;
+        }
+
+        static void check_groups_reset(void) {
+            for (size_t i = 0; i < check_group_count; i++)
+                free(check_groups[i].reference);
+            check_group_count = 0;
+        }
+
+        uint64_t bench_hash_bytes(const void *data, size_t len) {
+            const unsigned char *p = (const unsigned char*)data;
+            uint64_t h = 0xcbf29ce484222325ULL;
+            for (size_t i = 0; i < len; i++) {
+                h ^= p[i];
+                h *= 0x100000001b3ULL;
+            }
+            return h;
+        }
+
+        void bench_digest_f64(const double *v, size_t n, bench_digest_t *out) {
+            // Kahan summation keeps the tolerance check meaningful for long outputs
+            double sum = 0.0, c = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                double y = v[i] - c;
+                double t = sum + y;
+                c = (t - sum) - y;
+                sum = t;
+            }
+            out->hash  = bench_hash_bytes(v, n * sizeof(double));
+            out->value = sum;
+        }
+
+        void bench_group_tolerance(const char *group, double rel_tol) {
+            check_group_t *g = find_check_group(group);
+            if (g)
+                g->rel_tol = rel_tol;
+        }
+
+        static int digest_equal(const bench_digest_t *a, const bench_digest_t *b, double rel_tol) {
+            if (rel_tol <= 0.0)
+                return a->hash == b->hash;
+            if (a->value == b->value)
+                return 1;
+            double mag = fmax(fabs(a->value), fabs(b->value));
+            return fabs(a->value - b->value) <= rel_tol * mag;
+        }
+
+        int bench_run(const char *label, bench_fn fn, void *arg, size_t iterations) {
+            return bench_run_checked(NULL, label, fn, NULL, arg, iterations);
+        }
+
+        int bench_run_checked(const char *group, const char *label, bench_fn fn,
+                              bench_digest_fn digest, void *arg, size_t iterations) {
+            if (!label || !fn || iterations == 0) {
+                fprintf(stderr, "Error: bench_run() needs a label, a function and at least one iteration!\n");
+                return -1;
+            }
+
+            check_group_t   *g       = (group && digest) ? find_check_group(group) : NULL;
+            bench_samples_t *samples = find_samples(label);
+            bench_digest_t  *digests = NULL;
+            if (g) {
+                digests = (bench_digest_t*)calloc(iterations, sizeof(bench_digest_t));
+                if (!digests) {
+                    fprintf(stderr, "Error: Out of memory for %zu output digests!\n", iterations);
+                    g = NULL;
+                }
+            }
+
+            if (cgroup_stat_fd >= 0)
+                cgroup_region_begin();
+            int64_t total_ns = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                if (cold_file_count)
+                    cold_evict_all();
+                int64_t s = get_time_ns();
+                fn(arg);
+                int64_t d = get_time_ns() - s;
+                total_ns += d;
+
+                if (samples)
+                    samples_append(samples, d);
+                if (g)
+                    digest(arg, &digests[i]);
+            }
+
+            time_info *entry = record_entry(label, (long long)(total_ns / 1000));
+            if (entry && cgroup_stat_fd >= 0)
+                cgroup_region_end(entry);
+            if (!g) {
+                free(digests);
+                return 0;
+            }
+
+            if (!g->reference) {
+                g->reference       = digests;
+                g->reference_count = iterations;
+                if (entry)
+                    entry->flags |= BENCH_ENTRY_CHECKED;
+                return 0;
+            }
+
+            size_t mismatch_at = iterations;
+            for (size_t i = 0; i < iterations && mismatch_at == iterations; i++) {
+                // Variants may run more iterations than the reference; those
+                // are checked against the reference's last output.
+                size_t r = i < g->reference_count ? i : g->reference_count - 1;
+                if (!digest_equal(&digests[i], &g->reference[r], g->rel_tol))
+                    mismatch_at = i;
+            }
+            free(digests);
+
+            if (entry)
+                entry->flags |= BENCH_ENTRY_CHECKED | (mismatch_at < iterations ? BENCH_ENTRY_MISMATCH : 0);
+
+            if (mismatch_at < iterations) {
+                fprintf(stderr, "Warning: '%s' output differs from group '%s' reference at iteration %zu!\n",
+                        label, g->name, mismatch_at);
+                return 1;
+            }
+            return 0;
+        }
+
+        // ─── Kernel Trace Markers ─────────────────────────────────────────────────
+
+        static const char ftrace_begin_marker[] = "bench: begin\n";
+
+        static struct {
+            size_t  markers;          /**< Marker writes issued */
+            int64_t write_ns;         /**< Time spent inside those writes */
+        } ftrace_state;
+
+        int bench_ftrace_enable(int enabled) {
+            static const char *paths[] = {
+                "/sys/kernel/tracing/trace_marker",
+                "/sys/kernel/debug/tracing/trace_marker"
+            };
+
+            if (ftrace_fd >= 0) {
+                close(ftrace_fd);
+                ftrace_fd = -1;
+            }
+            if (!enabled)
+                return 0;
+
+            for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]) && ftrace_fd < 0; i++)
+                ftrace_fd = open(paths[i], O_WRONLY | O_CLOEXEC);
+
+            if (ftrace_fd < 0) {
+                fprintf(stderr, "Warning: trace_marker is not writable, ftrace markers disabled!\n");
+                return -1;
+            }
+            ftrace_state.markers  = 0;
+            ftrace_state.write_ns = 0;
+            return 0;
+        }
+
+        static void ftrace_write(const char *msg, size_t len) {
+            int64_t s = get_time_ns();
+            if (write(ftrace_fd, msg, len) < 0)
+                return;
+            // Any recording thread may write a marker.
+            __atomic_fetch_add(&ftrace_state.write_ns, get_time_ns() - s, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&ftrace_state.markers, 1, __ATOMIC_RELAXED);
+        }
+
+        static void ftrace_region_begin(void) {
+            ftrace_write(ftrace_begin_marker, sizeof(ftrace_begin_marker) - 1);
+        }
+
+        static void ftrace_region_end(const time_info *entry) {
+            char msg[MAX_FUNS_NAME_LENGTH + 48];
+            int  len = snprintf(msg, sizeof(msg), "bench: end %s %lld us\n", entry->function_name, entry->time_us);
+            if (len > 0)
+                ftrace_write(msg, (size_t)len < sizeof(msg) ? (size_t)len : sizeof(msg) - 1);
+        }
+
+        static void print_ftrace_overhead(void) {
+            if (ftrace_state.markers == 0)
+                return;
+
+            char mean_str[STRING_LENGTH], total_str[STRING_LENGTH];
+            format_scaled((double)ftrace_state.write_ns / (double)ftrace_state.markers * 1e-9, mean_str, STRING_LENGTH, "s");
+            format_scaled((double)ftrace_state.write_ns * 1e-9, total_str, STRING_LENGTH, "s");
+            fprintf(stdout, "%sftrace markers: %zu writes, %s each, %s total (outside timed regions)%s\n",
+                    BRIGHT_CYAN, ftrace_state.markers, mean_str, total_str, RESET);
+        }
+
+        // ─── Spans & Critical Path ────────────────────────────────────────────────
+
+        typedef struct {
+            int64_t start_ns;         /**< Begin timestamp */
+            int64_t end_ns;           /**< End timestamp, 0 while open */
+            int     label;            /**< Index into span_labels */
+            long    tid;              /**< Thread that began the span */
+            int     cpu_begin;        /**< CPU at begin, -1 if unknown */
+            int     cpu_end;          /**< CPU at end, -1 if unknown */
+        } span_record_t;
+
+        typedef struct {
+            int child;                /**< Dependent span */
+            int parent;               /**< Span it waits on */
+        } span_edge_t;
+
+        static span_record_t   spans[MAX_SPANS];
+        static span_edge_t     span_edges[MAX_SPAN_EDGES];
+        static char            span_labels[MAX_SPAN_LABELS][MAX_FUNS_NAME_LENGTH];
+        static int             span_label_count;
+        static int             span_count;
+        static int             span_edge_count;
+        static pthread_mutex_t span_label_lock = PTHREAD_MUTEX_INITIALIZER;
+
+        static void spans_reset(void) {
+            span_count       = 0;
+            span_edge_count  = 0;
+            span_label_count = 0;
+        }
+
+        static int span_label_id(const char *label) {
+            int id = -1;
+            pthread_mutex_lock(&span_label_lock);
+            for (int i = 0; i < span_label_count && id < 0; i++) {
+                if (strcmp(span_labels[i], label) == 0)
+                    id = i;
+            }
+            if (id < 0 && span_label_count < MAX_SPAN_LABELS) {
+                id = span_label_count;
+                strncpy(span_labels[id], label, MAX_FUNS_NAME_LENGTH - 1);
+                span_labels[id][MAX_FUNS_NAME_LENGTH - 1] = '\0';
+                span_label_count++;
+            }
+            pthread_mutex_unlock(&span_label_lock);
+            return id;
+        }
+
+        /** CPU the caller runs on, for per-CPU clock correction. */
+        static int current_cpu(void) {
+        #if defined(__linux__) && defined(__USE_GNU)
+            return sched_getcpu();
+        #elif defined(__linux__) && defined(SYS_getcpu)
+            unsigned cpu = 0;
+            return syscall(SYS_getcpu, &cpu, NULL, NULL) == 0 ? (int)cpu : -1;
+        #else
+            return -1;
+        #endif
+        }
+
+        bench_span_t bench_span_begin(const char *label) {
+            if (causal_active)
+                bench_causal_point();
+            int id = span_label_id(label);
+            if (id < 0) {
+                fprintf(stderr, "Error: Exceeded maximum number of span labels!\n");
+                return BENCH_SPAN_INVALID;
+            }
+            int slot = __atomic_fetch_add(&span_count, 1, __ATOMIC_RELAXED);
+            if (slot >= MAX_SPANS) {
+                __atomic_store_n(&span_count, MAX_SPANS, __ATOMIC_RELAXED);
+                fprintf(stderr, "Error: Exceeded maximum number of spans!\n");
+                return BENCH_SPAN_INVALID;
+            }
+            spans[slot].label    = id;
+            spans[slot].tid       = bench_thread_id();
+            spans[slot].end_ns    = 0;
+            spans[slot].cpu_end   = -1;
+            spans[slot].cpu_begin = current_cpu();
+            spans[slot].start_ns  = get_time_ns();
+            return slot;
+        }
+
+        void bench_span_end(bench_span_t span) {
+            if (span < 0 || span >= MAX_SPANS)
+                return;
+            spans[span].end_ns  = get_time_ns();
+            spans[span].cpu_end = current_cpu();
+            if (causal_active)
+                causal_region_end(span_labels[spans[span].label], spans[span].end_ns - spans[span].start_ns);
+        }
+
+        int bench_span_depends(bench_span_t child, bench_span_t parent) {
+            if (child < 0 || parent < 0 || child >= MAX_SPANS || parent >= MAX_SPANS || child == parent) {
+                fprintf(stderr, "Error: Invalid span dependency!\n");
+                return -1;
+            }
+            int slot = __atomic_fetch_add(&span_edge_count, 1, __ATOMIC_RELAXED);
+            if (slot >= MAX_SPAN_EDGES) {
+                __atomic_store_n(&span_edge_count, MAX_SPAN_EDGES, __ATOMIC_RELAXED);
+                fprintf(stderr, "Error: Exceeded maximum number of span dependencies!\n");
+                return -1;
+            }
+            span_edges[slot].child  = child;
+            span_edges[slot].parent = parent;
+            return 0;
+        }
+
+        /**
+        * Critical path method over span durations: earliest finish forward in
+        * topological order (Kahn), latest finish backward; slack = LF - EF.
+        * `indeg` is consumed. Returns the makespan, or -1 if the graph has a cycle.
+        */
+        static int64_t span_schedule(int n, const int64_t *dur, int *indeg, const int *out_start,
+                                     const int *out_child, int *order, int64_t *ef, int64_t *lf,
+                                     int *pred, int *last) {
+            int head = 0, tail = 0;
+            for (int i = 0; i < n; i++) {
+                ef[i]   = dur[i];
+                pred[i] = -1;
+                if (indeg[i] == 0)
+                    order[tail++] = i;
+            }
+            while (head < tail) {
+                int u = order[head++];
+                for (int e = out_start[u]; e < out_start[u + 1]; e++) {
+                    int c = out_child[e];
+                    if (ef[u] + dur[c] > ef[c]) {
+                        ef[c]   = ef[u] + dur[c];
+                        pred[c] = u;
+                    }
+                    if (--indeg[c] == 0)
+                        order[tail++] = c;
+                }
+            }
+            if (tail < n)
+                return -1;
+
+            *last = 0;
+            for (int i = 1; i < n; i++) {
+                if (ef[i] > ef[*last])
+                    *last = i;
+            }
+            int64_t makespan = ef[*last];
+            for (int k = n - 1; k >= 0; k--) {
+                int u = order[k];
+                lf[u] = makespan;
+                for (int e = out_start[u]; e < out_start[u + 1]; e++) {
+                    int c = out_child[e];
+                    if (lf[c] - dur[c] < lf[u])
+                        lf[u] = lf[c] - dur[c];
+                }
+            }
+            return makespan;
+        }
+
+        void print_bench_critical_path(void) {
+            int n      = span_count < MAX_SPANS ? span_count : MAX_SPANS;
+            int nedges = span_edge_count < MAX_SPAN_EDGES ? span_edge_count : MAX_SPAN_EDGES;
+            if (n == 0) {
+                fprintf(stdout, "\nNo spans recorded.\n");
+                return;
+            }
+
+            int64_t *dur = (int64_t*)malloc((size_t)n * 3 * sizeof(int64_t));
+            int     *idx = (int*)malloc(((size_t)n * 6 + 1 + (size_t)nedges) * sizeof(int));
+            if (!dur || !idx) {
+                fprintf(stderr, "Error: Memory allocation failed for critical path!\n");
+                free(dur);
+                free(idx);
+                return;
+            }
+            int64_t *ef        = dur + n;
+            int64_t *lf        = ef + n;
+            int     *indeg     = idx;
+            int     *order     = indeg + n;
+            int     *pred      = order + n;
+            int     *on_path   = pred + n;
+            int     *fill      = on_path + n;
+            int     *out_start = fill + n;          // n + 1 entries
+            int     *out_child = out_start + n + 1; // nedges entries
+
+            int64_t wall_lo = INT64_MAX, wall_hi = INT64_MIN, busy = 0;
+            int     open_spans = 0;
+            for (int i = 0; i < n; i++) {
+                // Both ends on the reference CPU's clock, in case the span migrated.
+                int64_t start = clock_correct(spans[i].start_ns, spans[i].cpu_begin);
+                int64_t end   = clock_correct(spans[i].end_ns, spans[i].cpu_end);
+                if (spans[i].end_ns == 0) {
+                    open_spans++;
+                    end = start;
+                }
+                dur[i] = end > start ? end - start : 0;
+                busy  += dur[i];
+                if (start < wall_lo) wall_lo = start;
+                if (end > wall_hi) wall_hi = end;
+                indeg[i]   = 0;
+                on_path[i] = 0;
+            }
+            memset(out_start, 0, (size_t)(n + 1) * sizeof(int));
+
+            // Compressed adjacency, parent -> children.
+            int used = 0;
+            for (int e = 0; e < nedges; e++) {
+                const span_edge_t *ed = &span_edges[e];
+                if (ed->child < n && ed->parent < n) {
+                    out_start[ed->parent + 1]++;
+                    indeg[ed->child]++;
+                    used++;
+                }
+            }
+            for (int i = 0; i < n; i++) {
+                out_start[i + 1] += out_start[i];
+                fill[i] = out_start[i];
+            }
+            for (int e = 0; e < nedges; e++) {
+                const span_edge_t *ed = &span_edges[e];
+                if (ed->child < n && ed->parent < n)
+                    out_child[fill[ed->parent]++] = ed->child;
+            }
+
+            int     last     = 0;
+            int64_t makespan = span_schedule(n, dur, indeg, out_start, out_child, order, ef, lf, pred, &last);
+            if (makespan < 0) {
+                fprintf(stderr, "Error: Span dependencies contain a cycle, no critical path!\n");
+                free(dur);
+                free(idx);
+                return;
+            }
+            int path_len = 0;
+            for (int u = last; u >= 0; u = pred[u]) {
+                on_path[u] = 1;
+                path_len++;
+            }
+
+            char path_str[STRING_LENGTH], wall_str[STRING_LENGTH], busy_str[STRING_LENGTH];
+            format_scaled((double)makespan * 1e-9, path_str, STRING_LENGTH, "s");
+            format_scaled((double)(wall_hi - wall_lo) * 1e-9, wall_str, STRING_LENGTH, "s");
+            format_scaled((double)busy * 1e-9, busy_str, STRING_LENGTH, "s");
+
+            const char *rule = "----------------------------------------------------------------------------------------------------";
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-20s | %7s | %10s | %8s | %11s | %11s | %11s |%s\n", BRIGHT_CYAN,
+                    "Stage", "Spans", "Path time", "Of path", "On path", "Min slack", "Mean slack", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (int l = 0; l < span_label_count; l++) {
+                int     count = 0, path_count = 0, off = 0;
+                int64_t path_ns = 0, min_slack = INT64_MAX;
+                double  slack_sum = 0.0;
+                for (int i = 0; i < n; i++) {
+                    if (spans[i].label != l)
+                        continue;
+                    count++;
+                    if (on_path[i]) {
+                        path_count++;
+                        path_ns += dur[i];
+                    } else {
+                        int64_t slack = lf[i] - ef[i];
+                        if (slack < min_slack) min_slack = slack;
+                        slack_sum += (double)slack;
+                        off++;
+                    }
+                }
+                if (count == 0)
+                    continue;
+
+                char time_str[STRING_LENGTH], min_str[STRING_LENGTH], mean_str[STRING_LENGTH];
+                format_scaled((double)path_ns * 1e-9, time_str, STRING_LENGTH, "s");
+                if (off > 0) {
+                    format_scaled((double)min_slack * 1e-9, min_str, STRING_LENGTH, "s");
+                    format_scaled(slack_sum / off * 1e-9, mean_str, STRING_LENGTH, "s");
+                } else {
+                    snprintf(min_str, STRING_LENGTH, "-");
+                    snprintf(mean_str, STRING_LENGTH, "-");
+                }
+                const char *color = path_count > 0 ? BRIGHT_YELLOW : "";
+                fprintf(stdout, "%s| %-20s | %7d | %10s | %7.2f%% | %5d/%-5d | %11s | %11s |%s\n",
+                        color, span_labels[l], count, time_str,
+                        makespan > 0 ? (double)path_ns * 100.0 / (double)makespan : 0.0,
+                        path_count, count, min_str, mean_str, path_count > 0 ? RESET : "");
+            }
+
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%scritical path: %s over %d spans, wall: %s, span sum: %s, parallelism: %.2f%s\n",
+                    BRIGHT_CYAN, path_str, path_len, wall_str, busy_str,
+                    makespan > 0 ? (double)busy / (double)makespan : 0.0, RESET);
+            if (open_spans > 0 || used < nedges)
+                fprintf(stderr, "Warning: %d spans never ended, %d dependencies ignored!\n", open_spans, nedges - used);
+
+            free(dur);
+            free(idx);
+        }
+
+        // ─── Parallel Regions ─────────────────────────────────────────────────────
+
+        static bench_par_t par_regions[MAX_PAR_REGIONS];
+        static size_t      par_region_count;
+
+        static void par_regions_reset(void) {
+            for (size_t i = 0; i < par_region_count; i++)
+                free(par_regions[i].slots);
+            memset(par_regions, 0, par_region_count * sizeof(bench_par_t));
+            par_region_count = 0;
+        }
+
+        static bench_par_t *find_par_region(const char *label) {
+            for (size_t i = 0; i < par_region_count; i++) {
+                if (strcmp(par_regions[i].label, label) == 0)
+                    return &par_regions[i];
+            }
+            return NULL;
+        }
+
+        bench_par_t *bench_par_begin(const char *label, int nthreads) {
+            if (nthreads < 1 || nthreads > MAX_PAR_THREADS) {
+                fprintf(stderr, "Error: Parallel region team size must be in [1, %d]!\n", MAX_PAR_THREADS);
+                return NULL;
+            }
+
+            bench_par_t *r = find_par_region(label);
+            if (!r) {
+                if (par_region_count >= MAX_PAR_REGIONS) {
+                    fprintf(stderr, "Error: Exceeded maximum number of parallel regions!\n");
+                    return NULL;
+                }
+                r = &par_regions[par_region_count++];
+                strncpy(r->label, label, sizeof(r->label) - 1);
+            }
+
+            if (nthreads > r->capacity) {
+                size_t bytes = (size_t)nthreads * sizeof(bench_par_slot_t);
+                bench_par_slot_t *slots = (bench_par_slot_t*)aligned_alloc(64, bytes);
+                if (!slots) {
+                    fprintf(stderr, "Error: Memory allocation failed for parallel region!\n");
+                    return NULL;
+                }
+                memset(slots, 0, bytes);
+                if (r->slots)
+                    memcpy(slots, r->slots, (size_t)r->capacity * sizeof(bench_par_slot_t));
+                free(r->slots);
+                r->slots    = slots;
+                r->capacity = nthreads;
+            }
+
+            for (int t = 0; t < nthreads; t++)
+                r->slots[t].run_busy = 0;
+            r->nthreads = nthreads;
+            r->start_ns = get_time_ns();
+            return r;
+        }
+
+        void bench_par_work_begin(bench_par_t *r, int thread) {
+            if (r && thread >= 0 && thread < r->nthreads)
+                r->slots[thread].mark = get_time_ns();
+        }
+
+        void bench_par_work_end(bench_par_t *r, int thread) {
+            if (r && thread >= 0 && thread < r->nthreads) {
+                bench_par_slot_t *s = &r->slots[thread];
+                int64_t d = get_time_ns() - s->mark;
+                s->run_busy += d;
+                s->busy     += d;
+            }
+        }
+
+        void bench_par_wait_begin(bench_par_t *r, int thread) {
+            if (r && thread >= 0 && thread < r->nthreads)
+                r->slots[thread].mark = get_time_ns();
+        }
+
+        void bench_par_wait_end(bench_par_t *r, int thread) {
+            if (r && thread >= 0 && thread < r->nthreads)
+                r->slots[thread].wait += get_time_ns() - r->slots[thread].mark;
+        }
+
+        void bench_par_end(bench_par_t *r) {
+            if (!r)
+                return;
+            int64_t wall = get_time_ns() - r->start_ns;
+
+            int64_t max_busy = 0, sum_busy = 0;
+            for (int t = 0; t < r->nthreads; t++) {
+                int64_t b = r->slots[t].run_busy;
+                if (b > max_busy) max_busy = b;
+                sum_busy += b;
+            }
+            r->runs++;
+            if (r->nthreads > r->max_threads)
+                r->max_threads = r->nthreads;   // at the join, after a runtime may have shrunk the team
+            r->wall_ns       += wall;
+            r->thread_ns     += wall * r->nthreads;
+            r->sum_max_busy  += max_busy;
+            r->sum_mean_busy += (double)sum_busy / (double)r->nthreads;
+
+            // One entry per label: OpenMP programs run far more regions than the table has slots.
+            if (!r->entry)
+                r->entry = record_entry(r->label, 0);
+            if (r->entry) {
+                long long total = (long long)((r->wall_ns + 500) / 1000);
+                __atomic_fetch_add(&benchmarks.total_time, total - r->entry->time_us, __ATOMIC_RELAXED);
+                r->entry->time_us = total;
+            }
+        }
+
+        int bench_par_stats(const char *label, bench_par_stats_t *out) {
+            const bench_par_t *r = find_par_region(label);
+            if (!r || r->runs == 0)
+                return -1;
+
+            int64_t busy_total = 0, wait_total = 0, lo = INT64_MAX, hi = 0;
+            double  mean = 0.0, m2 = 0.0;
+            for (int t = 0; t < r->max_threads; t++) {
+                int64_t b = r->slots[t].busy;
+                busy_total += b;
+                wait_total += r->slots[t].wait;
+                if (b < lo) lo = b;
+                if (b > hi) hi = b;
+                double delta = (double)b - mean;
+                mean += delta / (double)(t + 1);
+                m2   += delta * ((double)b - mean);
+            }
+
+            out->runs        = r->runs;
+            out->threads     = r->max_threads;
+            out->wall_ns     = r->wall_ns;
+            out->imbalance   = r->sum_mean_busy > 0.0 ? (double)r->sum_max_busy / r->sum_mean_busy : 1.0;
+            out->lost_ns     = r->thread_ns > busy_total ? r->thread_ns - busy_total : 0;
+            out->wait_ns     = wait_total;
+            out->min_busy_ns = lo;
+            out->max_busy_ns = hi;
+            out->busy_cv     = mean > 0.0 ? sqrt(m2 / (double)r->max_threads) / mean : 0.0;
+            return 0;
+        }
+
+        void print_bench_parallel(void) {
+            if (par_region_count == 0) {
+                fprintf(stdout, "\nNo parallel regions recorded.\n");
+                return;
+            }
+
+            const char *rule = "------------------------------------------------------------------------------------------"
+                               "----------------------------------";
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-20s | %7s | %7s | %11s | %9s | %11s | %11s | %11s | %11s | %7s |%s\n", BRIGHT_CYAN,
+                    "Region", "Threads", "Runs", "Wall", "Imbalance", "Lost", "Barrier", "Min busy", "Max busy", "CV", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (size_t i = 0; i < par_region_count; i++) {
+                bench_par_stats_t st;
+                if (bench_par_stats(par_regions[i].label, &st) != 0)
+                    continue;
+
+                double values[5] = { (double)st.wall_ns, (double)st.lost_ns, (double)st.wait_ns,
+                                     (double)st.min_busy_ns, (double)st.max_busy_ns };
+                char   strs[5][STRING_LENGTH];
+                for (int k = 0; k < 5; k++)
+                    format_scaled(values[k] * 1e-9, strs[k], STRING_LENGTH, "s");
+
+                // Over 10% of the slowest thread's work is waited for by the rest of the team.
+                const char *color = st.imbalance > 1.10 ? BRIGHT_RED : BRIGHT_GREEN;
+                fprintf(stdout, "| %-20s | %7d | %7zu | %11s | %s%8.3fx%s | %11s | %11s | %11s | %11s | %6.1f%% |\n",
+                        par_regions[i].label, st.threads, st.runs, strs[0], color, st.imbalance, RESET,
+                        strs[1], strs[2], strs[3], strs[4], st.busy_cv * 100.0);
+            }
+
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%sImbalance: slowest / mean thread work per run. Lost: team time not spent working.%s\n",
+                    BRIGHT_CYAN, RESET);
+        }
+
+        // ─── OpenMP Tool (OMPT) ───────────────────────────────────────────────────
+
+        #if defined(BENCH_OMPT)
+
+        #include <omp-tools.h>
+        #include <dlfcn.h>
+
+        #define OMPT_TASK_STARTED (1ULL << 63)
+
+        static int ompt_active;
+
+        // Team membership of the calling thread in the outermost traced region.
+        static __thread bench_par_t *ompt_region;
+        static __thread size_t       ompt_run;
+        static __thread int          ompt_index;
+        static __thread int          ompt_waiting;
+        static __thread bench_span_t ompt_loop_span = BENCH_SPAN_INVALID;
+
+        /** "<kind>@<function>+<offset>" when the symbol is exported, "<kind>@<address>" otherwise. */
+        static void ompt_label(char *buf, size_t len, const char *kind, const void *codeptr) {
+        #if defined(__USE_GNU)
+            Dl_info info;
+            if (codeptr && dladdr(codeptr, &info) && info.dli_sname) {
+                snprintf(buf, len, "%s@%s+0x%lx", kind, info.dli_sname,
+                         (unsigned long)((const char*)codeptr - (const char*)info.dli_saddr));
+                return;
+            }
+        #endif
+            snprintf(buf, len, "%s@%p", kind, codeptr);
+        }
+
+        /** Callbacks of an execution that has already been joined are dropped. */
+        static bench_par_t *ompt_current_region(void) {
+            bench_par_t *r = ompt_region;
+            if (r && __atomic_load_n(&r->runs, __ATOMIC_RELAXED) != ompt_run)
+                return NULL;
+            return r;
+        }
+
+        static void ompt_on_parallel_begin(ompt_data_t *encountering_task_data, const ompt_frame_t *encountering_task_frame,
+                                           ompt_data_t *parallel_data, unsigned int requested_parallelism,
+                                           int flags, const void *codeptr_ra) {
+            (void)encountering_task_data; (void)encountering_task_frame;
+            parallel_data->ptr = NULL;
+            if (!(flags & ompt_parallel_team) || ompt_current_region())
+                return;
+
+            char label[MAX_FUNS_NAME_LENGTH];
+            ompt_label(label, sizeof(label), "par", codeptr_ra);
+            parallel_data->ptr = bench_par_begin(label, (int)requested_parallelism);
+        }
+
+        static void ompt_on_parallel_end(ompt_data_t *parallel_data, ompt_data_t *encountering_task_data,
+                                         int flags, const void *codeptr_ra) {
+            (void)encountering_task_data; (void)flags; (void)codeptr_ra;
+            if (parallel_data->ptr)
+                bench_par_end((bench_par_t*)parallel_data->ptr);
+        }
+
+        static void ompt_on_implicit_task(ompt_scope_endpoint_t endpoint, ompt_data_t *parallel_data,
+                                          ompt_data_t *task_data, unsigned int actual_parallelism,
+                                          unsigned int index, int flags) {
+            (void)task_data;
+            if (flags & ompt_task_initial)
+                return;
+
+            if (endpoint == ompt_scope_begin) {
+                bench_par_t *r = parallel_data ? (bench_par_t*)parallel_data->ptr : NULL;
+                if (!r)
+                    return;
+                // The team was sized from the requested parallelism; the runtime may grant fewer threads.
+                if ((int)actual_parallelism >= 1 && (int)actual_parallelism < __atomic_load_n(&r->nthreads, __ATOMIC_RELAXED))
+                    __atomic_store_n(&r->nthreads, (int)actual_parallelism, __ATOMIC_RELAXED);
+                ompt_region = r;
+                ompt_run    = __atomic_load_n(&r->runs, __ATOMIC_RELAXED);
+                ompt_index  = (int)index;
+                bench_par_work_begin(r, ompt_index);
+            } else if (endpoint == ompt_scope_end) {
+                bench_par_t *r = ompt_current_region();
+                if (r)
+                    bench_par_work_end(r, ompt_index);
+                ompt_region = NULL;
+            }
+        }
+
+        static void ompt_on_sync_region_wait(ompt_sync_region_t kind, ompt_scope_endpoint_t endpoint,
+                                             ompt_data_t *parallel_data, ompt_data_t *task_data,
+                                             const void *codeptr_ra) {
+            (void)kind; (void)parallel_data; (void)task_data; (void)codeptr_ra;
+            bench_par_t *r = ompt_current_region();
+            if (!r)
+                return;
+            if (endpoint == ompt_scope_begin) {
+                bench_par_work_end(r, ompt_index);
+                bench_par_wait_begin(r, ompt_index);
+                ompt_waiting = 1;
+            } else if (endpoint == ompt_scope_end) {
+                bench_par_wait_end(r, ompt_index);
+                bench_par_work_begin(r, ompt_index);
+                ompt_waiting = 0;
+            }
+        }
+
+        static void ompt_on_work(ompt_work_t wstype, ompt_scope_endpoint_t endpoint, ompt_data_t *parallel_data,
+                                 ompt_data_t *task_data, uint64_t count, const void *codeptr_ra) {
+            (void)parallel_data; (void)task_data; (void)count;
+            if (wstype != ompt_work_loop)
+                return;
+            if (endpoint == ompt_scope_begin) {
+                char label[MAX_FUNS_NAME_LENGTH];
+                ompt_label(label, sizeof(label), "for", codeptr_ra);
+                ompt_loop_span = bench_span_begin(label);
+            } else if (endpoint == ompt_scope_end) {
+                bench_span_end(ompt_loop_span);
+                ompt_loop_span = BENCH_SPAN_INVALID;
+            }
+        }
+
+        static void ompt_on_task_create(ompt_data_t *encountering_task_data, const ompt_frame_t *encountering_task_frame,
+                                        ompt_data_t *new_task_data, int flags, int has_dependences,
+                                        const void *codeptr_ra) {
+            (void)encountering_task_data; (void)encountering_task_frame; (void)has_dependences;
+            new_task_data->value = 0;
+            if (!(flags & ompt_task_explicit))
+                return;
+
+            char label[MAX_FUNS_NAME_LENGTH];
+            ompt_label(label, sizeof(label), "task", codeptr_ra);
+            bench_span_t span = bench_span_begin(label);
+            if (span != BENCH_SPAN_INVALID)
+                new_task_data->value = (uint64_t)span + 1;
+        }
+
+        static void ompt_on_task_schedule(ompt_data_t *prior_task_data, ompt_task_status_t prior_task_status,
+                                          ompt_data_t *next_task_data) {
+            // Explicit tasks run by a thread waiting at a barrier count as work, not wait.
+            int prior_explicit = prior_task_data && prior_task_data->value;
+            int next_explicit  = next_task_data && next_task_data->value;
+            bench_par_t *r = ompt_current_region();
+            if (r && ompt_waiting && prior_explicit != next_explicit) {
+                if (next_explicit) {
+                    bench_par_wait_end(r, ompt_index);
+                    bench_par_work_begin(r, ompt_index);
+                } else {
+                    bench_par_work_end(r, ompt_index);
+                    bench_par_wait_begin(r, ompt_index);
+                }
+            }
+
+            // A task's span runs from its first dispatch to its completion.
+            if (prior_task_data && prior_task_data->value &&
+                (prior_task_status == ompt_task_complete || prior_task_status == ompt_task_cancel))
+                bench_span_end((bench_span_t)((prior_task_data->value & ~OMPT_TASK_STARTED) - 1));
+
+            if (next_explicit && !(next_task_data->value & OMPT_TASK_STARTED)) {
+                span_record_t *s = &spans[(next_task_data->value & ~OMPT_TASK_STARTED) - 1];
+                s->tid       = bench_thread_id();
+                s->cpu_begin = current_cpu();
+                s->start_ns  = get_time_ns();
+                next_task_data->value |= OMPT_TASK_STARTED;
+            }
+        }
+
+        static void ompt_on_task_dependence(ompt_data_t *src_task_data, ompt_data_t *sink_task_data) {
+            if (src_task_data->value && sink_task_data->value)
+                bench_span_depends((bench_span_t)((sink_task_data->value & ~OMPT_TASK_STARTED) - 1),
+                                   (bench_span_t)((src_task_data->value & ~OMPT_TASK_STARTED) - 1));
+        }
+
+        static int ompt_initialize(ompt_function_lookup_t lookup, int initial_device_num, ompt_data_t *tool_data) {
+            (void)initial_device_num; (void)tool_data;
+            ompt_set_callback_t set_callback = (ompt_set_callback_t)lookup("ompt_set_callback");
+            if (!set_callback)
+                return 0;
+
+            set_callback(ompt_callback_parallel_begin,   (ompt_callback_t)ompt_on_parallel_begin);
+            set_callback(ompt_callback_parallel_end,     (ompt_callback_t)ompt_on_parallel_end);
+            set_callback(ompt_callback_implicit_task,    (ompt_callback_t)ompt_on_implicit_task);
+            set_callback(ompt_callback_sync_region_wait, (ompt_callback_t)ompt_on_sync_region_wait);
+            set_callback(ompt_callback_work,             (ompt_callback_t)ompt_on_work);
+            set_callback(ompt_callback_task_create,      (ompt_callback_t)ompt_on_task_create);
+            set_callback(ompt_callback_task_schedule,    (ompt_callback_t)ompt_on_task_schedule);
+            set_callback(ompt_callback_task_dependence,  (ompt_callback_t)ompt_on_task_dependence);
+            ompt_active = 1;
+            return 1;
+        }
+
+        static void ompt_finalize(ompt_data_t *tool_data) {
+            (void)tool_data;
+            ompt_active = 0;
+        }
+
+        ompt_start_tool_result_t *ompt_start_tool(unsigned int omp_version, const char *runtime_version) {
+            static ompt_start_tool_result_t result = { ompt_initialize, ompt_finalize, { 0 } };
+            (void)omp_version; (void)runtime_version;
+            return &result;
+        }
+
+        int bench_ompt_active(void) {
+            return ompt_active;
+        }
+
+        #else
+
+        int bench_ompt_active(void) {
+            return 0;
+        }
+
+        #endif // BENCH_OMPT
+
+        // ─── Top-down Analysis ────────────────────────────────────────────────────
+
+        #define TMA_MAX_EVENTS 8
+
+        enum { TMA_NONE, TMA_INTEL_METRICS, TMA_INTEL_SLOTS, TMA_AMD_PIPELINE, TMA_GENERIC };
+
+        typedef struct {
+            int      fd[TMA_MAX_EVENTS];        /**< fd[0] is the group leader */
+            int      count;                     /**< Open events, 0 = group unavailable */
+            double   scale[TMA_MAX_EVENTS];     /**< Per-event multiplier from sysfs `<event>.scale` */
+            uint64_t begin[3 + TMA_MAX_EVENTS]; /**< Group read at region begin */
+        } tma_group_t;
+
+        static struct {
+            int          kind;                  /**< TMA_* level-1 source */
+            const char  *source;                /**< Description for reports */
+            unsigned     mask;                  /**< Measurable categories */
+            int          mem_in_l1;             /**< Intel topdown-mem-bound is part of the level-1 group */
+            tma_group_t  l1;                    /**< Level-1 slot accounting */
+            tma_group_t  l2;                    /**< Backend memory/core split */
+        } tma_state = { TMA_NONE, "none", 0, 0, { { 0 }, 0, { 0 }, { 0 } }, { { 0 }, 0, { 0 }, { 0 } } };
+
+        static const char *const tma_names[BENCH_TMA_COUNT] = {
+            "Retiring", "Bad speculation", "Frontend bound", "Backend bound", "Memory bound", "Core bound"
+        };
+
+        const char *bench_tma_name(bench_tma_class c) {
+            return (c >= 0 && c < BENCH_TMA_COUNT) ? tma_names[c] : "?";
+        }
+
+        const char *bench_tma_source(void) {
+            return tma_state.source;
+        }
+
+        unsigned bench_tma_available(void) {
+            return tma_state.mask;
+        }
+
+        #if defined(BENCH_HAVE_PERF)
+
+        typedef struct {
+            uint32_t type;
+            uint64_t config;
+            double   scale;                     /**< Count multiplier, 0 = 1 */
+        } tma_event_t;
+
+        /**
+        * Parses a sysfs event spec such as "event=0x00,umask=0x80" (Intel layout)
+        * and its optional `<event>.scale` file. The pre-Ice Lake slot aliases need
+        * both: topdown-total-slots is cycles with AnyThread and a scale of 4 (2
+        * with SMT), so ignoring either puts every fraction off by that factor.
+        */
+        static int tma_sysfs_event(const char *pmu, const char *name, tma_event_t *ev) {
+            char path[128], spec[128];
+            snprintf(path, sizeof(path), "/sys/bus/event_source/devices/%s/type", pmu);
+            FILE *f = fopen(path, "r");
+            if (!f)
+                return -1;
+            int ok = fscanf(f, "%u", &ev->type) == 1;
+            fclose(f);
+
+            snprintf(path, sizeof(path), "/sys/bus/event_source/devices/%s/events/%s", pmu, name);
+            f = fopen(path, "r");
+            if (!ok || !f) {
+                if (f) fclose(f);
+                return -1;
+            }
+            ok = fgets(spec, sizeof(spec), f) != NULL;
+            fclose(f);
+            if (!ok)
+                return -1;
+
+            ev->config = 0;
+            for (char *tok = strtok(spec, ",\n"); tok; tok = strtok(NULL, ",\n")) {
+                char *eq = strchr(tok, '=');
+                uint64_t v = eq ? strtoull(eq + 1, NULL, 0) : 1;
+                if (eq) *eq = '\0';
+                if      (strcmp(tok, "event") == 0) ev->config |= v & 0xff;
+                else if (strcmp(tok, "umask") == 0) ev->config |= (v & 0xff) << 8;
+                else if (strcmp(tok, "edge")  == 0) ev->config |= (v & 1) << 18;
+                else if (strcmp(tok, "any")   == 0) ev->config |= (v & 1) << 21;
+                else if (strcmp(tok, "inv")   == 0) ev->config |= (v & 1) << 23;
+                else if (strcmp(tok, "cmask") == 0) ev->config |= (v & 0xff) << 24;
+            }
+
+            ev->scale = 1.0;
+            snprintf(path, sizeof(path), "/sys/bus/event_source/devices/%s/events/%s.scale", pmu, name);
+            if ((f = fopen(path, "r")) != NULL) {
+                double scale;
+                if (fscanf(f, "%lf", &scale) == 1 && scale > 0.0)
+                    ev->scale = scale;
+                fclose(f);
+            }
+            return 0;
+        }
+
+        static const char *tma_core_pmu(void) {
+            // Hybrid parts name the big-core PMU "cpu_core".
+            return access("/sys/bus/event_source/devices/cpu_core/type", R_OK) == 0 ? "cpu_core" : "cpu";
+        }
+
+        static void tma_close_group(tma_group_t *g) {
+            for (int i = g->count - 1; i >= 0; i--)
+                close(g->fd[i]);
+            g->count = 0;
+        }
+
+        static int tma_open_group(tma_group_t *g, const tma_event_t *events, int n) {
+            g->count = 0;
+            for (int i = 0; i < n; i++) {
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size           = sizeof(attr);
+                attr.type           = events[i].type;
+                attr.config         = events[i].config;
+                attr.disabled       = i == 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : g->fd[0], 0);
+                if (fd < 0) {
+                    tma_close_group(g);
+                    return -1;
+                }
+                g->scale[g->count] = events[i].scale > 0.0 ? events[i].scale : 1.0;
+                g->fd[g->count++]  = fd;
+            }
+            ioctl(g->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(g->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            return 0;
+        }
+
+        static int tma_read_group(const tma_group_t *g, uint64_t *buf) {
+            ssize_t want = (ssize_t)((3 + g->count) * sizeof(uint64_t));
+            return read(g->fd[0], buf, (size_t)want) == want ? 0 : -1;
+        }
+
+        static void tma_cpu_id(char *vendor, unsigned *family, unsigned *model) {
+            strcpy(vendor, "unknown");
+            *family = *model = 0;
+        #if defined(__x86_64__) && defined(__GNUC__)
+            unsigned a, b, c, d;
+            if (__get_cpuid(0, &a, &b, &c, &d)) {
+                memcpy(vendor, &b, 4);
+                memcpy(vendor + 4, &d, 4);
+                memcpy(vendor + 8, &c, 4);
+                vendor[12] = '\0';
+            }
+            if (__get_cpuid(1, &a, &b, &c, &d)) {
+                *family = (a >> 8) & 0xf;
+                *model  = (a >> 4) & 0xf;
+                if (*family == 0xf)
+                    *family += (a >> 20) & 0xff;
+                if (*family == 0x6 || *family >= 0xf)
+                    *model |= ((a >> 16) & 0xf) << 4;
+            }
+        #endif
+        }
+
+        /** AMD raw encoding: event select bits [7:0] and [35:32], unit mask [15:8]. */
+        static tma_event_t tma_amd_event(unsigned event, unsigned umask) {
+            tma_event_t ev = { PERF_TYPE_RAW, (event & 0xffULL) | ((uint64_t)umask << 8) | ((uint64_t)(event >> 8) << 32), 1.0 };
+            return ev;
+        }
+
+        static int tma_open_intel(void) {
+            const char *pmu = tma_core_pmu();
+            tma_event_t ev[TMA_MAX_EVENTS];
+
+            // Ice Lake and later: fixed slots counter + PERF_METRICS, level 2 memory on Sapphire Rapids.
+            static const char *metrics[] = { "slots", "topdown-retiring", "topdown-bad-spec",
+                                             "topdown-fe-bound", "topdown-be-bound", "topdown-mem-bound" };
+            int n = 0;
+            while (n < 6 && tma_sysfs_event(pmu, metrics[n], &ev[n]) == 0)
+                n++;
+            if (n >= 5 && tma_open_group(&tma_state.l1, ev, n) == 0) {
+                tma_state.kind      = TMA_INTEL_METRICS;
+                tma_state.source    = "Intel topdown metrics";
+                tma_state.mem_in_l1 = n == 6;
+                return 0;
+            }
+
+            // Skylake-era kernel aliases for the classic slot formulas.
+            static const char *slots[] = { "topdown-total-slots", "topdown-slots-issued", "topdown-slots-retired",
+                                           "topdown-fetch-bubbles", "topdown-recovery-bubbles" };
+            for (n = 0; n < 5; n++) {
+                if (tma_sysfs_event(pmu, slots[n], &ev[n]) != 0)
+                    return -1;
+            }
+            if (tma_open_group(&tma_state.l1, ev, 5) != 0)
+                return -1;
+            tma_state.kind   = TMA_INTEL_SLOTS;
+            tma_state.source = "Intel topdown slots";
+            return 0;
+        }
+
+        static int tma_open_amd(unsigned family, unsigned model) {
+            // PMCx1A0 (dispatch slots) exists from Zen 4 on.
+            int zen4 = family > 0x19 || (family == 0x19 && ((model >= 0x10 && model <= 0x1f) ||
+                                                            (model >= 0x60 && model <= 0xaf)));
+            if (!zen4)
+                return -1;
+
+            tma_event_t l1[5] = {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1.0 },
+                tma_amd_event(0x1a0, 0x01),   // de_no_dispatch_per_slot.no_ops_from_frontend
+                tma_amd_event(0x1a0, 0x1e),   // de_no_dispatch_per_slot.backend_stalls
+                tma_amd_event(0x0c1, 0x00),   // ex_ret_ops
+                tma_amd_event(0x0aa, 0x07),   // de_src_op_disp.all
+            };
+            if (tma_open_group(&tma_state.l1, l1, 5) != 0)
+                return -1;
+
+            tma_event_t l2[2] = {
+                tma_amd_event(0x0d6, 0x01),   // ex_no_retire.not_complete
+                tma_amd_event(0x0d6, 0x02),   // ex_no_retire.load_not_complete
+            };
+            tma_open_group(&tma_state.l2, l2, 2);
+            tma_state.kind   = TMA_AMD_PIPELINE;
+            tma_state.source = "AMD pipeline utilization";
+            return 0;
+        }
+
+        static int tma_open_generic(void) {
+            tma_event_t ev[3] = {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 1.0 },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND, 1.0 },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, 1.0 },
+            };
+            if (tma_open_group(&tma_state.l1, ev, 3) != 0)
+                return -1;
+            tma_state.kind   = TMA_GENERIC;
+            tma_state.source = "generic stalled cycles";
+            return 0;
+        }
+
+        int bench_tma_enable(int enabled) {
+            tma_close_group(&tma_state.l1);
+            tma_close_group(&tma_state.l2);
+            tma_state.kind      = TMA_NONE;
+            tma_state.source    = "none";
+            tma_state.mask      = 0;
+            tma_state.mem_in_l1 = 0;
+            tma_owner           = 0;
+            if (!enabled)
+                return 0;
+
+            char     vendor[16];
+            unsigned family, model;
+            tma_cpu_id(vendor, &family, &model);
+
+            int rc = -1;
+            if (strcmp(vendor, "GenuineIntel") == 0)
+                rc = tma_open_intel();
+            else if (strcmp(vendor, "AuthenticAMD") == 0)
+                rc = tma_open_amd(family, model);
+            if (rc != 0)
+                rc = tma_open_generic();
+            if (rc != 0) {
+                fprintf(stderr, "Warning: No usable PMU counters (perf_event_open), top-down analysis disabled!\n");
+                return -1;
+            }
+
+            const unsigned l1_all = (1u << BENCH_TMA_RETIRING) | (1u << BENCH_TMA_BAD_SPECULATION) |
+                                    (1u << BENCH_TMA_FRONTEND) | (1u << BENCH_TMA_BACKEND);
+            const unsigned split  = (1u << BENCH_TMA_BACKEND_MEMORY) | (1u << BENCH_TMA_BACKEND_CORE);
+
+            if (tma_state.kind == TMA_GENERIC) {
+                tma_state.mask = (1u << BENCH_TMA_FRONTEND) | (1u << BENCH_TMA_BACKEND);
+            } else {
+                // Intel CYCLE_ACTIVITY.STALLS_TOTAL (cmask 4) and STALLS_MEM_ANY (cmask 20).
+                if (tma_state.kind != TMA_AMD_PIPELINE && !tma_state.mem_in_l1) {
+                    tma_event_t l2[2] = { { PERF_TYPE_RAW, 0x040004a3, 1.0 }, { PERF_TYPE_RAW, 0x140014a3, 1.0 } };
+                    tma_open_group(&tma_state.l2, l2, 2);
+                }
+                tma_state.mask = l1_all | ((tma_state.mem_in_l1 || tma_state.l2.count) ? split : 0);
+            }
+            tma_owner = 1;
+            return 0;
+        }
+
+        static void tma_region_begin(void) {
+            if (tma_read_group(&tma_state.l1, tma_state.l1.begin) != 0)
+                tma_state.l1.begin[0] = 0;
+            if (tma_state.l2.count && tma_read_group(&tma_state.l2, tma_state.l2.begin) != 0)
+                tma_state.l2.begin[0] = 0;
+        }
+
+        /** Event deltas of a group over the region; -1 if it was never scheduled. */
+        static int tma_group_delta(const tma_group_t *g, double *delta) {
+            uint64_t now[3 + TMA_MAX_EVENTS];
+            if (g->count == 0 || g->begin[0] == 0 || tma_read_group(g, now) != 0)
+                return -1;
+            if (now[2] == g->begin[2])
+                return -1;
+            // Fractions are ratios within one group, so multiplexing scale factors cancel;
+            // the sysfs per-event scales (slots per count) do not.
+            for (int i = 0; i < g->count; i++)
+                delta[i] = (double)(now[3 + i] - g->begin[3 + i]) * g->scale[i];
+            return 0;
+        }
+
+        static double tma_clamp(double x) {
+            return x < 0.0 ? 0.0 : (x > 1.0 ? 1.0 : x);
+        }
+
+        static void tma_region_end(time_info *entry) {
+            double d[TMA_MAX_EVENTS], f[BENCH_TMA_COUNT] = { 0 };
+            if (tma_group_delta(&tma_state.l1, d) != 0 || d[0] <= 0.0)
+                return;
+
+            double mem_share = -1.0;
+            switch (tma_state.kind) {
+                case TMA_INTEL_METRICS:
+                    f[BENCH_TMA_RETIRING]         = d[1] / d[0];
+                    f[BENCH_TMA_BAD_SPECULATION]  = d[2] / d[0];
+                    f[BENCH_TMA_FRONTEND]         = d[3] / d[0];
+                    f[BENCH_TMA_BACKEND]          = d[4] / d[0];
+                    if (tma_state.mem_in_l1 && d[4] > 0.0)
+                        mem_share = d[5] / d[4];
+                    break;
+                case TMA_INTEL_SLOTS:
+                    f[BENCH_TMA_FRONTEND]         = d[3] / d[0];
+                    f[BENCH_TMA_BAD_SPECULATION]  = (d[1] - d[2] + d[4]) / d[0];
+                    f[BENCH_TMA_RETIRING]         = d[2] / d[0];
+                    f[BENCH_TMA_BACKEND]          = 1.0 - f[BENCH_TMA_FRONTEND] - f[BENCH_TMA_BAD_SPECULATION] - f[BENCH_TMA_RETIRING];
+                    break;
+                case TMA_AMD_PIPELINE: {
+                    double slots = 6.0 * d[0];   // Zen 4 dispatches up to 6 ops per cycle
+                    f[BENCH_TMA_FRONTEND]         = d[1] / slots;
+                    f[BENCH_TMA_BACKEND]          = d[2] / slots;
+                    f[BENCH_TMA_RETIRING]         = d[3] / slots;
+                    f[BENCH_TMA_BAD_SPECULATION]  = (d[4] - d[3]) / slots;
+                    break;
+                }
+                default:
+                    f[BENCH_TMA_FRONTEND]         = d[1] / d[0];
+                    f[BENCH_TMA_BACKEND]          = d[2] / d[0];
+                    break;
+            }
+
+            double l2[2];
+            // Intel: STALLS_MEM_ANY / STALLS_TOTAL, AMD: load_not_complete / not_complete.
+            if (mem_share < 0.0 && tma_group_delta(&tma_state.l2, l2) == 0 && l2[0] > 0.0)
+                mem_share = l2[1] / l2[0];
+
+            unsigned mask = tma_state.mask;
+            if (mem_share >= 0.0) {
+                f[BENCH_TMA_BACKEND_MEMORY] = f[BENCH_TMA_BACKEND] * tma_clamp(mem_share);
+                f[BENCH_TMA_BACKEND_CORE]   = f[BENCH_TMA_BACKEND] - f[BENCH_TMA_BACKEND_MEMORY];
+            } else {
+                mask &= ~((1u << BENCH_TMA_BACKEND_MEMORY) | (1u << BENCH_TMA_BACKEND_CORE));
+            }
+
+            for (int c = 0; c < BENCH_TMA_COUNT; c++)
+                entry->tma[c] = (float)tma_clamp(f[c]);
+            entry->tma_mask = mask;
+            entry->flags   |= BENCH_ENTRY_TMA;
+        }
+
+        #else
+
+        int bench_tma_enable(int enabled) {
+            if (enabled)
+                fprintf(stderr, "Warning: Top-down analysis needs Linux perf events!\n");
+            return enabled ? -1 : 0;
+        }
+
+        static void tma_region_begin(void) {}
+        static void tma_region_end(time_info *entry) { (void)entry; }
+
+        #endif // BENCH_HAVE_PERF
+
+        static void print_tma_bar(const time_info *entry) {
+            static const char *colors[BENCH_TMA_COUNT] = { GREEN, RED, MAGENTA, BRIGHT_YELLOW, BLUE, BRIGHT_YELLOW };
+            if (!(entry->flags & BENCH_ENTRY_TMA)) {
+                fprintf(stdout, "%-*s", TMA_BAR_WIDTH, "-");
+                return;
+            }
+
+            // Level 1 segments, with the backend drawn as memory + core when split.
+            int split = (entry->tma_mask & (1u << BENCH_TMA_BACKEND_MEMORY)) != 0;
+            const bench_tma_class order[] = { BENCH_TMA_RETIRING, BENCH_TMA_BAD_SPECULATION, BENCH_TMA_FRONTEND,
+                                              split ? BENCH_TMA_BACKEND_MEMORY : BENCH_TMA_BACKEND,
+                                              split ? BENCH_TMA_BACKEND_CORE   : BENCH_TMA_COUNT };
+            double edge = 0.0;
+            int    drawn = 0;
+            for (size_t k = 0; k < sizeof(order) / sizeof(order[0]); k++) {
+                bench_tma_class c = order[k];
+                if (c == BENCH_TMA_COUNT || !(entry->tma_mask & (1u << c)))
+                    continue;
+                edge += entry->tma[c];
+                int upto = (int)(edge * TMA_BAR_WIDTH + 0.5);
+                if (upto > TMA_BAR_WIDTH) upto = TMA_BAR_WIDTH;
+                fprintf(stdout, "%s", colors[c]);
+                for (; drawn < upto; drawn++)
+                    fprintf(stdout, "█");
+            }
+            fprintf(stdout, "%s", RESET);
+            for (; drawn < TMA_BAR_WIDTH; drawn++)
+                fprintf(stdout, "·");   // not measurable with the available counters
+        }
+
+        static void print_tma_legend(void) {
+            fprintf(stdout, "%sTop-down (%s): %s█%s retiring, %s█%s bad speculation, %s█%s frontend, "
+                            "%s█%s backend memory, %s█%s backend core/all, · unmeasured%s\n",
+                    BRIGHT_CYAN, tma_state.source, GREEN, BRIGHT_CYAN, RED, BRIGHT_CYAN, MAGENTA, BRIGHT_CYAN,
+                    BLUE, BRIGHT_CYAN, BRIGHT_YELLOW, BRIGHT_CYAN, RESET);
+        }
+
+        // ─── Replay Corpora ───────────────────────────────────────────────────────
+
+        typedef struct {
+            size_t  calls;            /**< Records replayed */
+            int64_t ns;               /**< Time spent in the body */
+            size_t  bytes;            /**< Record bytes replayed */
+        } corpus_bucket_t;
+
+        typedef struct {
+            char            label[MAX_FUNS_NAME_LENGTH];
+            corpus_bucket_t buckets[CORPUS_SIZE_BUCKETS];
+        } corpus_result_t;
+
+        static corpus_result_t corpus_results[MAX_CORPUS_LABELS];
+        static size_t          corpus_result_count;
+
+        static void corpus_results_reset(void) {
+            corpus_result_count = 0;
+        }
+
+        /** Bucket b holds sizes in [2^(b-1), 2^b), bucket 0 holds empty records. */
+        static int corpus_bucket(size_t size) {
+            int b = 0;
+            while (size && b < CORPUS_SIZE_BUCKETS - 1) {
+                size >>= 1;
+                b++;
+            }
+            return b;
+        }
+
+        static int corpus_add_map(bench_corpus_t *c, void *base, size_t len) {
+            void  **maps  = (void**)realloc(c->maps, (c->map_count + 1) * sizeof(void*));
+            if (maps) c->maps = maps;
+            size_t *sizes = (size_t*)realloc(c->map_sizes, (c->map_count + 1) * sizeof(size_t));
+            if (sizes) c->map_sizes = sizes;
+            if (!maps || !sizes)
+                return -1;
+            c->maps[c->map_count]      = base;
+            c->map_sizes[c->map_count] = len;
+            c->map_count++;
+            return 0;
+        }
+
+        static int corpus_add_record(bench_corpus_t *c, size_t *capacity, const unsigned char *data, size_t size) {
+            if (c->count == *capacity) {
+                size_t          cap = *capacity ? *capacity * 2 : 1024;
+                bench_record_t *r   = (bench_record_t*)realloc(c->records, cap * sizeof(bench_record_t));
+                if (!r)
+                    return -1;
+                c->records = r;
+                *capacity  = cap;
+            }
+            c->records[c->count].data = data;
+            c->records[c->count].size = size;
+            c->count++;
+            c->bytes += size;
+            return 0;
+        }
+
+        /** Maps a whole file read-only; an empty file yields a NULL mapping. */
+        static int corpus_map_file(bench_corpus_t *c, const char *path, const unsigned char **base, size_t *len) {
+            int fd = open(path, O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (fd < 0 || fstat(fd, &st) != 0) {
+                fprintf(stderr, "Error: Cannot open corpus file '%s'!\n", path);
+                if (fd >= 0) close(fd);
+                return -1;
+            }
+            *base = NULL;
+            *len  = (size_t)st.st_size;
+            if (*len == 0) {
+                close(fd);
+                return 0;
+            }
+
+        #if defined(MAP_POPULATE)
+            int   populate = (c->flags & BENCH_CORPUS_PREFAULT) ? MAP_POPULATE : 0;
+        #else
+            int   populate = 0;
+        #endif
+            void *p        = mmap(NULL, *len, PROT_READ, MAP_PRIVATE | populate, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED || corpus_add_map(c, p, *len) != 0) {
+                fprintf(stderr, "Error: Cannot map corpus file '%s'!\n", path);
+                if (p != MAP_FAILED) munmap(p, *len);
+                return -1;
+            }
+            *base = (const unsigned char*)p;
+            return 0;
+        }
+
+        static int corpus_load_records(bench_corpus_t *c, const char *path) {
+            const unsigned char *base;
+            size_t               len, capacity = 0;
+            if (corpus_map_file(c, path, &base, &len) != 0)
+                return -1;
+
+            size_t pos = 0;
+            while (pos < len) {
+                if (len - pos < 4) {
+                    fprintf(stderr, "Error: Truncated length prefix at offset %zu in '%s'!\n", pos, path);
+                    return -1;
+                }
+                size_t size = (size_t)base[pos] | (size_t)base[pos + 1] << 8 |
+                              (size_t)base[pos + 2] << 16 | (size_t)base[pos + 3] << 24;
+                pos += 4;
+                if (size > len - pos) {
+                    fprintf(stderr, "Error: Record at offset %zu overruns '%s'!\n", pos - 4, path);
+                    return -1;
+                }
+                if (corpus_add_record(c, &capacity, base + pos, size) != 0)
+                    return -1;
+                pos += size;
+            }
+            return 0;
+        }
+
+        static int compare_names(const void *a, const void *b) {
+            return strcmp(*(char *const *)a, *(char *const *)b);
+        }
+
+        static int corpus_load_dir(bench_corpus_t *c, const char *path) {
+            DIR *dir = opendir(path);
+            if (!dir) {
+                fprintf(stderr, "Error: Cannot open corpus directory '%s'!\n", path);
+                return -1;
+            }
+
+            // Sorted names keep the unshuffled order reproducible.
+            char         **names = NULL;
+            size_t         n = 0, cap = 0;
+            struct dirent *de;
+            int            rc = 0;
+            while ((de = readdir(dir)) != NULL && rc == 0) {
+                if (de->d_name[0] == '.')
+                    continue;
+                if (n == cap) {
+                    cap = cap ? cap * 2 : 256;
+                    char **grown = (char**)realloc(names, cap * sizeof(char*));
+                    if (!grown) { rc = -1; break; }
+                    names = grown;
+                }
+                size_t need = strlen(path) + strlen(de->d_name) + 2;
+                if ((names[n] = (char*)malloc(need)) == NULL) { rc = -1; break; }
+                snprintf(names[n++], need, "%s/%s", path, de->d_name);
+            }
+            closedir(dir);
+            if (rc == 0)
+                qsort(names, n, sizeof(char*), compare_names);
+
+            size_t capacity = 0;
+            for (size_t i = 0; i < n; i++) {
+                struct stat st;
+                const unsigned char *base;
+                size_t len;
+                if (rc == 0 && stat(names[i], &st) == 0 && S_ISREG(st.st_mode)) {
+                    if (corpus_map_file(c, names[i], &base, &len) != 0 ||
+                        corpus_add_record(c, &capacity, base, len) != 0)
+                        rc = -1;
+                }
+                free(names[i]);
+            }
+            free(names);
+            if (rc != 0)
+                fprintf(stderr, "Error: Failed to load corpus directory '%s'!\n", path);
+            return rc;
+        }
+
+        static void corpus_shuffle(bench_corpus_t *c) {
+            for (size_t i = c->count; i > 1; i--) {
+                size_t j   = (size_t)(bench_random() % i);
+                size_t tmp = c->order[i - 1];
+                c->order[i - 1] = c->order[j];
+                c->order[j]     = tmp;
+            }
+        }
+
+        int bench_corpus_open(bench_corpus_t *corpus, const char *path, unsigned flags) {
+            memset(corpus, 0, sizeof(*corpus));
+            corpus->flags = flags;
+
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                fprintf(stderr, "Error: Corpus '%s' does not exist!\n", path);
+                return -1;
+            }
+            int rc = S_ISDIR(st.st_mode) ? corpus_load_dir(corpus, path) : corpus_load_records(corpus, path);
+            if (rc == 0 && corpus->count > 0) {
+                corpus->order = (size_t*)malloc(corpus->count * sizeof(size_t));
+                if (!corpus->order)
+                    rc = -1;
+            }
+            if (rc != 0) {
+                bench_corpus_close(corpus);
+                return -1;
+            }
+
+            for (size_t i = 0; i < corpus->count; i++)
+                corpus->order[i] = i;
+            if (flags & BENCH_CORPUS_SHUFFLE)
+                corpus_shuffle(corpus);
+
+            long page = sysconf(_SC_PAGESIZE);
+            for (size_t m = 0; m < corpus->map_count; m++) {
+                if ((corpus->flags & BENCH_CORPUS_LOCK) && mlock(corpus->maps[m], corpus->map_sizes[m]) != 0) {
+                    fprintf(stderr, "Warning: mlock of corpus failed (RLIMIT_MEMLOCK?), pages may be evicted!\n");
+                    corpus->flags &= ~BENCH_CORPUS_LOCK;
+                }
+                if (flags & BENCH_CORPUS_PREFAULT) {
+                    // MAP_POPULATE is best effort; touching every page makes it certain.
+                    volatile const unsigned char *p = (const unsigned char*)corpus->maps[m];
+                    for (size_t off = 0; off < corpus->map_sizes[m]; off += (size_t)page)
+                        (void)p[off];
+                }
+            }
+            return 0;
+        }
+
+        const bench_record_t *bench_corpus_next(bench_corpus_t *corpus) {
+            if (corpus->count == 0)
+                return NULL;
+            if (corpus->cursor == corpus->count) {
+                corpus->cursor = 0;
+                corpus->passes++;
+                if (corpus->flags & BENCH_CORPUS_SHUFFLE)
+                    corpus_shuffle(corpus);
+            }
+            return &corpus->records[corpus->order[corpus->cursor++]];
+        }
+
+        void bench_corpus_close(bench_corpus_t *corpus) {
+            for (size_t m = 0; m < corpus->map_count; m++) {
+                if (corpus->flags & BENCH_CORPUS_LOCK)
+                    munlock(corpus->maps[m], corpus->map_sizes[m]);
+                munmap(corpus->maps[m], corpus->map_sizes[m]);
+            }
+            free(corpus->maps);
+            free(corpus->map_sizes);
+            free(corpus->records);
+            free(corpus->order);
+            memset(corpus, 0, sizeof(*corpus));
+        }
+
+        static corpus_result_t *find_corpus_result(const char *label) {
+            for (size_t i = 0; i < corpus_result_count; i++) {
+                if (strcmp(corpus_results[i].label, label) == 0)
+                    return &corpus_results[i];
+            }
+            if (corpus_result_count >= MAX_CORPUS_LABELS) {
+                fprintf(stderr, "Error: Exceeded maximum number of corpus labels!\n");
+                return NULL;
+            }
+            corpus_result_t *r = &corpus_results[corpus_result_count++];
+            memset(r, 0, sizeof(*r));
+            strncpy(r->label, label, sizeof(r->label) - 1);
+            return r;
+        }
+
+        int bench_run_corpus(const char *label, bench_corpus_fn fn, void *arg, bench_corpus_t *corpus, size_t iterations) {
+            if (!label || !fn || !corpus || corpus->count == 0 || iterations == 0) {
+                fprintf(stderr, "Error: bench_run_corpus() needs a label, a function, a non-empty corpus and iterations!\n");
+                return -1;
+            }
+
+            corpus_result_t *result  = find_corpus_result(label);
+            bench_samples_t *samples = find_samples(label);
+            int64_t          total_ns = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                const bench_record_t *rec = bench_corpus_next(corpus);
+                int64_t s = get_time_ns();
+                fn(rec->data, rec->size, arg);
+                int64_t d = get_time_ns() - s;
+                total_ns += d;
+
+                if (result) {
+                    corpus_bucket_t *bk = &result->buckets[corpus_bucket(rec->size)];
+                    bk->calls++;
+                    bk->ns    += d;
+                    bk->bytes += rec->size;
+                }
+                if (samples)
+                    samples_append(samples, d);
+            }
+
+            record_entry(label, (long long)(total_ns / 1000));
+            return 0;
+        }
+
+        /** Power-of-two sizes with binary prefixes ("512 B", "16 KiB"). */
+        static void corpus_size_str(unsigned long long v, char *buf, size_t len) {
+            static const char *units[] = { "B", "KiB", "MiB", "GiB", "TiB" };
+            int u = 0;
+            while (v >= 1024 && u < 4) {
+                v >>= 10;
+                u++;
+            }
+            snprintf(buf, len, "%u %s", (unsigned)(v & 1023), units[u]);
+        }
+
+        void print_bench_corpus(void) {
+            if (corpus_result_count == 0) {
+                fprintf(stdout, "\nNo corpus replays recorded.\n");
+                return;
+            }
+
+            const char *rule = "---------------------------------------------------------------------------------------------------";
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-20s | %-19s | %10s | %11s | %11s | %13s |%s\n", BRIGHT_CYAN,
+                    "Function", "Record size", "Calls", "Mean", "Total", "Throughput", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (size_t i = 0; i < corpus_result_count; i++) {
+                const corpus_result_t *r = &corpus_results[i];
+                for (int b = 0; b < CORPUS_SIZE_BUCKETS; b++) {
+                    const corpus_bucket_t *bk = &r->buckets[b];
+                    if (bk->calls == 0)
+                        continue;
+
+                    char range[STRING_LENGTH], lo_str[12], hi_str[12];
+                    char mean_str[STRING_LENGTH], total_str[STRING_LENGTH], rate_str[STRING_LENGTH];
+                    if (b == 0) {
+                        snprintf(range, sizeof(range), "empty");
+                    } else {
+                        corpus_size_str(1ULL << (b - 1), lo_str, sizeof(lo_str));
+                        corpus_size_str(1ULL << b, hi_str, sizeof(hi_str));
+                        snprintf(range, sizeof(range), "[%s, %s)", lo_str, hi_str);
+                    }
+                    format_scaled((double)bk->ns / (double)bk->calls * 1e-9, mean_str, STRING_LENGTH, "s");
+                    format_scaled((double)bk->ns * 1e-9, total_str, STRING_LENGTH, "s");
+                    if (bk->bytes > 0 && bk->ns > 0)
+                        format_scaled((double)bk->bytes / ((double)bk->ns * 1e-9), rate_str, STRING_LENGTH, "B/s");
+                    else
+                        snprintf(rate_str, STRING_LENGTH, "-");
+
+                    fprintf(stdout, "| %-20s | %-19s | %10zu | %11s | %11s | %13s |\n",
+                            r->label, range, bk->calls, mean_str, total_str, rate_str);
+                }
+            }
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+        }
+
+        // ─── Causal Profiling ─────────────────────────────────────────────────────
+
+        typedef struct {
+            char     name[MAX_FUNS_NAME_LENGTH];
+            uint64_t count;
+        } progress_point_t;
+
+        typedef struct {
+            size_t   runs;            /**< Experiments */
+            uint64_t progress;        /**< Progress-point visits during them */
+            int64_t  effective_ns;    /**< Wall time minus inserted delay */
+        } causal_bin_t;
+
+        typedef struct {
+            char         label[MAX_FUNS_NAME_LENGTH];
+            causal_bin_t bins[CAUSAL_SPEEDUP_STEPS + 1];   /**< Index = speedup in tenths */
+        } causal_region_t;
+
+        static progress_point_t progress_points[MAX_PROGRESS_POINTS];
+        static int              progress_point_count;
+        static pthread_mutex_t  progress_lock = PTHREAD_MUTEX_INITIALIZER;
+
+        static struct {
+            causal_region_t  regions[MAX_CAUSAL_REGIONS];
+            int              region_count;
+            pthread_mutex_t  lock;                /**< Guards region registration */
+            int              target;              /**< Region under experiment, -1 = none */
+            int              speedup;             /**< Virtual speedup in tenths */
+            int64_t          global_delay;        /**< Delay every thread must have paid (ns) */
+            uint64_t        *progress;            /**< Measured progress point */
+            unsigned         experiment_ms;
+            int              stop;
+            pthread_t        thread;
+        } causal_state = { .lock = PTHREAD_MUTEX_INITIALIZER, .target = -1 };
+
+        static __thread int64_t causal_local_delay;
+        static __thread int     causal_joined;
+
+        uint64_t *bench_progress_point(const char *name) {
+            uint64_t *counter = NULL;
+            pthread_mutex_lock(&progress_lock);
+            for (int i = 0; i < progress_point_count && !counter; i++) {
+                if (strcmp(progress_points[i].name, name) == 0)
+                    counter = &progress_points[i].count;
+            }
+            if (!counter && progress_point_count < MAX_PROGRESS_POINTS) {
+                progress_point_t *p = &progress_points[progress_point_count++];
+                strncpy(p->name, name, sizeof(p->name) - 1);
+                counter = &p->count;
+            }
+            pthread_mutex_unlock(&progress_lock);
+            if (!counter)
+                fprintf(stderr, "Error: Exceeded maximum number of progress points!\n");
+            return counter;
+        }
+
+        /** Sleeps for long delays, spins for short ones where sleep granularity would overshoot. */
+        static void causal_pause(int64_t ns) {
+            if (ns > 100000) {
+                struct timespec ts = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+                nanosleep(&ts, NULL);
+                return;
+            }
+            int64_t until = get_time_ns() + ns;
+            while (get_time_ns() < until)
+                ;
+        }
+
+        void bench_causal_point(void) {
+            if (!causal_active)
+                return;
+            int64_t global = __atomic_load_n(&causal_state.global_delay, __ATOMIC_ACQUIRE);
+            if (!causal_joined) {
+                // Threads owe nothing for delays inserted before they first showed up.
+                causal_local_delay = global;
+                causal_joined      = 1;
+                return;
+            }
+            if (causal_local_delay < global) {
+                causal_pause(global - causal_local_delay);
+                causal_local_delay = global;
+            }
+        }
+
+        static int causal_find_region(const char *label) {
+            int n = __atomic_load_n(&causal_state.region_count, __ATOMIC_ACQUIRE);
+            for (int i = 0; i < n; i++) {
+                if (strcmp(causal_state.regions[i].label, label) == 0)
+                    return i;
+            }
+
+            int id = -1;
+            pthread_mutex_lock(&causal_state.lock);
+            n = causal_state.region_count;
+            for (int i = 0; i < n && id < 0; i++) {
+                if (strcmp(causal_state.regions[i].label, label) == 0)
+                    id = i;
+            }
+            if (id < 0 && n < MAX_CAUSAL_REGIONS) {
+                strncpy(causal_state.regions[n].label, label, MAX_FUNS_NAME_LENGTH - 1);
+                __atomic_store_n(&causal_state.region_count, n + 1, __ATOMIC_RELEASE);
+                id = n;
+            }
+            pthread_mutex_unlock(&causal_state.lock);
+            return id;
+        }
+
+        static void causal_region_end(const char *label, int64_t elapsed_ns) {
+            int id     = causal_find_region(label);
+            int target = __atomic_load_n(&causal_state.target, __ATOMIC_ACQUIRE);
+            if (id >= 0 && id == target && elapsed_ns > 0) {
+                // Speeding this thread up by s*d is the same as delaying every other thread by s*d.
+                int64_t delay = elapsed_ns * __atomic_load_n(&causal_state.speedup, __ATOMIC_RELAXED) / CAUSAL_SPEEDUP_STEPS;
+                __atomic_fetch_add(&causal_state.global_delay, delay, __ATOMIC_ACQ_REL);
+                causal_local_delay += delay;
+            }
+            bench_causal_point();
+        }
+
+        static void *causal_main(void *arg) {
+            (void)arg;
+            struct timespec period = {
+                (time_t)(causal_state.experiment_ms / 1000),
+                (long)(causal_state.experiment_ms % 1000) * 1000000L
+            };
+
+            while (!__atomic_load_n(&causal_state.stop, __ATOMIC_ACQUIRE)) {
+                int n = __atomic_load_n(&causal_state.region_count, __ATOMIC_ACQUIRE);
+                if (n == 0) {
+                    nanosleep(&period, NULL);
+                    continue;
+                }
+
+                int region  = (int)(bench_random() % (uint64_t)n);
+                int speedup = (bench_random() & 1) ? 1 + (int)(bench_random() % CAUSAL_SPEEDUP_STEPS) : 0;
+
+                uint64_t p0 = __atomic_load_n(causal_state.progress, __ATOMIC_RELAXED);
+                int64_t  d0 = __atomic_load_n(&causal_state.global_delay, __ATOMIC_ACQUIRE);
+                int64_t  t0 = get_time_ns();
+                __atomic_store_n(&causal_state.speedup, speedup, __ATOMIC_RELAXED);
+                __atomic_store_n(&causal_state.target, speedup ? region : -1, __ATOMIC_RELEASE);
+
+                nanosleep(&period, NULL);
+
+                __atomic_store_n(&causal_state.target, -1, __ATOMIC_RELEASE);
+                uint64_t p1 = __atomic_load_n(causal_state.progress, __ATOMIC_RELAXED);
+                int64_t  d1 = __atomic_load_n(&causal_state.global_delay, __ATOMIC_ACQUIRE);
+                int64_t  t1 = get_time_ns();
+
+                int64_t effective = (t1 - t0) - (d1 - d0);
+                if (effective <= 0)
+                    continue;
+                causal_bin_t *bin = &causal_state.regions[region].bins[speedup];
+                bin->runs++;
+                bin->progress     += p1 - p0;
+                bin->effective_ns += effective;
+            }
+            return NULL;
+        }
+
+        int bench_causal_start(const char *progress, unsigned experiment_ms) {
+            bench_causal_stop();
+
+            causal_state.progress = bench_progress_point(progress);
+            if (!causal_state.progress || experiment_ms == 0)
+                return -1;
+            for (int i = 0; i < causal_state.region_count; i++)
+                memset(causal_state.regions[i].bins, 0, sizeof(causal_state.regions[i].bins));
+
+            causal_state.experiment_ms = experiment_ms;
+            causal_state.stop          = 0;
+            causal_active              = 1;
+            if (pthread_create(&causal_state.thread, NULL, causal_main, NULL) != 0) {
+                causal_active = 0;
+                fprintf(stderr, "Error: Could not start the causal profiling thread!\n");
+                return -1;
+            }
+            return 0;
+        }
+
+        void bench_causal_stop(void) {
+            if (!causal_active)
+                return;
+            __atomic_store_n(&causal_state.stop, 1, __ATOMIC_RELEASE);
+            pthread_join(causal_state.thread, NULL);
+            causal_active = 0;
+        }
+
+        void print_bench_causal(void) {
+            // Speedup 0 does not depend on the region: pool it into one baseline.
+            uint64_t base_progress = 0;
+            int64_t  base_ns       = 0;
+            size_t   base_runs     = 0;
+            for (int i = 0; i < causal_state.region_count; i++) {
+                base_progress += causal_state.regions[i].bins[0].progress;
+                base_ns       += causal_state.regions[i].bins[0].effective_ns;
+                base_runs     += causal_state.regions[i].bins[0].runs;
+            }
+            if (base_runs == 0 || base_progress == 0) {
+                fprintf(stdout, "\nNo causal profiling baseline (no progress during unsped experiments).\n");
+                return;
+            }
+            double base_rate = (double)base_progress / (double)base_ns;
+
+            fprintf(stdout, "%s-------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%s| %-20s |", BRIGHT_CYAN, "Region speedup");
+            for (int s = 1; s <= CAUSAL_SPEEDUP_STEPS; s++)
+                fprintf(stdout, " %6d%% |", s * 100 / CAUSAL_SPEEDUP_STEPS);
+            fprintf(stdout, "%s\n", RESET);
+            fprintf(stdout, "%s-------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+
+            for (int i = 0; i < causal_state.region_count; i++) {
+                const causal_region_t *r = &causal_state.regions[i];
+                fprintf(stdout, "| %-20s |", r->label);
+                for (int s = 1; s <= CAUSAL_SPEEDUP_STEPS; s++) {
+                    const causal_bin_t *bin = &r->bins[s];
+                    if (bin->runs == 0 || bin->effective_ns <= 0) {
+                        fprintf(stdout, " %7s |", "-");
+                        continue;
+                    }
+                    double impact = ((double)bin->progress / (double)bin->effective_ns / base_rate - 1.0) * 100.0;
+                    const char *color = impact > 5.0 ? BRIGHT_GREEN : (impact < -5.0 ? BRIGHT_RED : NULL);
+                    if (color)
+                        fprintf(stdout, " %s%+6.1f%%%s |", color, impact, RESET);
+                    else
+                        fprintf(stdout, " %+6.1f%% |", impact);
+                }
+                fprintf(stdout, "\n");
+            }
+
+            fprintf(stdout, "%s-------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%sThroughput change of the progress point per virtual region speedup (baseline: %zu experiments, %.1f/s)%s\n",
+                    BRIGHT_CYAN, base_runs, base_rate * 1e9, RESET);
+        }
+
+        // ─── Reference Kernels ────────────────────────────────────────────────────
+
+        #define REF_INT_ITERS     (1u << 22)
+        #define REF_FP_ITERS      (1u << 22)
+        #define REF_CHASE_LOADS   (1u << 18)
+
+        static const char *const ref_names[BENCH_REF_COUNT] = { "int", "fp", "lat", "bw" };
+
+        static struct {
+            int      done;
+            double   pass_us[BENCH_REF_COUNT];
+            struct {
+                char label[MAX_FUNS_NAME_LENGTH];
+                int  kind;
+            } labels[MAX_REF_LABELS];
+            int      label_count;
+        } ref_state;
+
+        static volatile uint64_t ref_sink;
+
+        static uint64_t ref_int_kernel(void) {
+            // Four independent chains keep the multipliers busy rather than measuring one latency.
+            uint64_t a = 1, b = 2, c = 3, d = 4;
+            for (uint32_t i = 0; i < REF_INT_ITERS; i++) {
+                a = (a * 6364136223846793005ULL + i) ^ (a >> 29);
+                b = (b * 6364136223846793005ULL + i) ^ (b >> 29);
+                c = (c * 6364136223846793005ULL + i) ^ (c >> 29);
+                d = (d * 6364136223846793005ULL + i) ^ (d >> 29);
+            }
+            return a ^ b ^ c ^ d;
+        }
+
+        static uint64_t ref_fp_kernel(void) {
+            double a = 1.0, b = 1.1, c = 1.2, d = 1.3;
+            const double m = 0.999999, k = 1e-7;
+            for (uint32_t i = 0; i < REF_FP_ITERS; i++) {
+                a = a * m + k;
+                b = b * m + k;
+                c = c * m + k;
+                d = d * m + k;
+            }
+            return (uint64_t)((a + b + c + d) * 1e6);
+        }
+
+        static uint64_t ref_latency_kernel(const size_t *next) {
+            size_t p = 0;
+            for (uint32_t i = 0; i < REF_CHASE_LOADS; i++)
+                p = next[p];
+            return p;
+        }
+
+        static uint64_t ref_bandwidth_kernel(const uint64_t *buf, size_t n) {
+            uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            for (size_t i = 0; i + 3 < n; i += 4) {
+                s0 += buf[i];
+                s1 += buf[i + 1];
+                s2 += buf[i + 2];
+                s3 += buf[i + 3];
+            }
+            return s0 + s1 + s2 + s3;
+        }
+
+        int bench_reference_run(void) {
+            if (ref_state.done)
+                return 0;
+
+            size_t  n    = REF_BUFFER_BYTES / sizeof(size_t);
+            size_t *next = (size_t*)malloc(n * sizeof(size_t));
+            if (!next) {
+                fprintf(stderr, "Error: Could not allocate the reference kernel buffer!\n");
+                return -1;
+            }
+
+            // Sattolo's algorithm: a single cycle through every slot defeats the prefetchers.
+            // A private generator keeps the user's bench_random() stream untouched.
+            uint64_t rng = 0x9E3779B97F4A7C15ULL;
+            for (size_t i = 0; i < n; i++)
+                next[i] = i;
+            for (size_t i = n - 1; i > 0; i--) {
+                rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+                size_t j   = (size_t)(rng % i);
+                size_t tmp = next[i];
+                next[i] = next[j];
+                next[j] = tmp;
+            }
+
+            for (int k = 0; k < BENCH_REF_COUNT; k++) {
+                int64_t best = INT64_MAX;
+                for (int run = 0; run < REF_KERNEL_RUNS; run++) {
+                    int64_t t0 = get_time_ns();
+                    switch (k) {
+                        case BENCH_REF_INT:       ref_sink = ref_int_kernel(); break;
+                        case BENCH_REF_FP:        ref_sink = ref_fp_kernel(); break;
+                        case BENCH_REF_LATENCY:   ref_sink = ref_latency_kernel(next); break;
+                        case BENCH_REF_BANDWIDTH: ref_sink = ref_bandwidth_kernel((const uint64_t*)next, REF_BUFFER_BYTES / sizeof(uint64_t)); break;
+                    }
+                    int64_t elapsed = get_time_ns() - t0;
+                    if (elapsed < best)
+                        best = elapsed;
+                }
+                ref_state.pass_us[k] = (double)best / 1000.0;
+            }
+
+            free(next);
+            ref_state.done = 1;
+            return 0;
+        }
+
+        double bench_reference_score(bench_ref_kind kind) {
+            if (!ref_state.done || kind < 0 || kind >= BENCH_REF_COUNT)
+                return 0.0;
+            return ref_state.pass_us[kind];
+        }
+
+        const char *bench_reference_name(bench_ref_kind kind) {
+            if (kind < 0 || kind >= BENCH_REF_COUNT)
+                return "?";
+            return ref_names[kind];
+        }
+
+        int bench_normalize(const char *label, bench_ref_kind kind) {
+            if (kind < 0 || kind >= BENCH_REF_COUNT)
+                return -1;
+            if (bench_reference_run() != 0)
+                return -1;
+
+            for (int i = 0; i < ref_state.label_count; i++) {
+                if (strcmp(ref_state.labels[i].label, label) == 0) {
+                    ref_state.labels[i].kind = kind;
+                    return 0;
+                }
+            }
+            if (ref_state.label_count >= MAX_REF_LABELS) {
+                fprintf(stderr, "Error: Exceeded maximum number of normalized labels!\n");
+                return -1;
+            }
+            strncpy(ref_state.labels[ref_state.label_count].label, label, MAX_FUNS_NAME_LENGTH - 1);
+            ref_state.labels[ref_state.label_count].kind = kind;
+            ref_state.label_count++;
+            return 0;
+        }
+
+        static int ref_label_kind(const char *label) {
+            if (!ref_state.done)
+                return -1;
+            for (int i = 0; i < ref_state.label_count; i++) {
+                if (strcmp(ref_state.labels[i].label, label) == 0)
+                    return ref_state.labels[i].kind;
+            }
+            return -1;
+        }
+
+        static void print_ref_cell(const time_info *entry) {
+            int kind = ref_label_kind(entry->function_name);
+            if (kind < 0) {
+                fprintf(stdout, "%12s", "-");
+                return;
+            }
+            char cell[STRING_LENGTH];
+            snprintf(cell, sizeof(cell), "%.4g x %s", (double)entry->time_us / ref_state.pass_us[kind], ref_names[kind]);
+            fprintf(stdout, "%12s", cell);
+        }
+
+        static void print_ref_legend(void) {
+            fprintf(stdout, "%sNormalized: time / one pass of a reference kernel (", BRIGHT_CYAN);
+            const char *sep = "";
+            for (int k = 0; k < BENCH_REF_COUNT; k++) {
+                int used = 0;
+                for (int i = 0; i < ref_state.label_count && !used; i++)
+                    used = ref_state.labels[i].kind == k;
+                if (used) {
+                    fprintf(stdout, "%s%s = %.1f µs", sep, ref_names[k], ref_state.pass_us[k]);
+                    sep = ", ";
+                }
+            }
+            fprintf(stdout, ")%s\n", RESET);
+        }
+
+        static void read_cpu_model(char *model, size_t size) {
+            snprintf(model, size, "unknown");
+            FILE *f = fopen("/proc/cpuinfo", "r");
+            if (!f)
+                return;
+            char line[256];
+            while (fgets(line, sizeof(line), f)) {
+                char *colon = strchr(line, ':');
+                if (colon && strncmp(line, "model name", 10) == 0) {
+                    colon++;
+                    while (*colon == ' ' || *colon == '\t')
+                        colon++;
+                    colon[strcspn(colon, "\n")] = '\0';
+                    snprintf(model, size, "%s", colon);
+                    break;
+                }
+            }
+            fclose(f);
+        }
+
+        void print_bench_env(void) {
+            struct utsname host;
+            char model[128];
+            if (uname(&host) != 0)
+                memset(&host, 0, sizeof(host));
+            read_cpu_model(model, sizeof(model));
+
+            fprintf(stdout, "%s── Environment ──────────────────────────────────────────%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "Host      : %s (%s %s, %s)\n", host.nodename, host.sysname, host.release, host.machine);
+            fprintf(stdout, "CPU       : %s, %ld online\n", model, sysconf(_SC_NPROCESSORS_ONLN));
+            double limit = bench_cgroup_cpu_limit();
+            if (limit > 0.0)
+                fprintf(stdout, "CPU limit : %.2f CPUs (cgroup quota)\n", limit);
+            else
+                fprintf(stdout, "CPU limit : %s\n", limit == 0.0 ? "none" : "unknown");
+            if (!ref_state.done) {
+                fprintf(stdout, "Reference : not run\n");
+                return;
+            }
+
+            char rate[STRING_LENGTH];
+            format_scaled(4.0 * 4.0 * REF_INT_ITERS / (ref_state.pass_us[BENCH_REF_INT] * 1e-6), rate, sizeof(rate), "op/s");
+            fprintf(stdout, "Reference : int %10.1f µs  (%s)\n", ref_state.pass_us[BENCH_REF_INT], rate);
+            format_scaled(4.0 * 2.0 * REF_FP_ITERS / (ref_state.pass_us[BENCH_REF_FP] * 1e-6), rate, sizeof(rate), "FLOP/s");
+            fprintf(stdout, "            fp  %10.1f µs  (%s)\n", ref_state.pass_us[BENCH_REF_FP], rate);
+            fprintf(stdout, "            lat %10.1f µs  (%.1f ns per load)\n", ref_state.pass_us[BENCH_REF_LATENCY],
+                    ref_state.pass_us[BENCH_REF_LATENCY] * 1000.0 / REF_CHASE_LOADS);
+            format_scaled(REF_BUFFER_BYTES / (ref_state.pass_us[BENCH_REF_BANDWIDTH] * 1e-6), rate, sizeof(rate), "B/s");
+            fprintf(stdout, "            bw  %10.1f µs  (%s)\n", ref_state.pass_us[BENCH_REF_BANDWIDTH], rate);
+        }
+
+        // ─── ISA Variants ─────────────────────────────────────────────────────────
+
+        typedef struct {
+            char            label[MAX_FUNS_NAME_LENGTH];
+            bench_isa_level level;
+            int             ran;            /**< 0 = not built or unsupported by the host */
+            int             mismatch;       /**< Output differed from the first variant */
+            double          ns_per_call;
+        } isa_result_t;
+
+        static isa_result_t isa_results[MAX_ISA_RESULTS];
+        static size_t       isa_result_count;
+
+        static const char *const isa_names[BENCH_ISA_COUNT] = { "x86-64", "x86-64-v2", "x86-64-v3", "x86-64-v4" };
+
+        static void isa_results_reset(void) {
+            isa_result_count = 0;
+        }
+
+        int bench_isa_supported(bench_isa_level level) {
+        #if defined(__x86_64__) && defined(__GNUC__)
+            // Feature lists rather than the "x86-64-vN" names, which need GCC 12.
+            // libgcc also checks XCR0, so AVX state the OS does not save reads as unsupported.
+            __builtin_cpu_init();
+            int v2 = __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt") &&
+                     __builtin_cpu_supports("ssse3");
+            int v3 = v2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                     __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2");
+            int v4 = v3 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                     __builtin_cpu_supports("avx512cd") && __builtin_cpu_supports("avx512dq") &&
+                     __builtin_cpu_supports("avx512vl");
+            switch (level) {
+                case BENCH_ISA_BASELINE: return 1;
+                case BENCH_ISA_V2:       return v2;
+                case BENCH_ISA_V3:       return v3;
+                case BENCH_ISA_V4:       return v4;
+                default:                 return 0;
+            }
+        #else
+            return level == BENCH_ISA_BASELINE;
+        #endif
+        }
+
+        const char *bench_isa_name(bench_isa_level level) {
+            if (level < 0 || level >= BENCH_ISA_COUNT)
+                return "?";
+            return isa_names[level];
+        }
+
+        int bench_run_isa(const char *label, const bench_isa_variant_t *variants,
+                          bench_digest_fn digest, void *arg, size_t iterations) {
+            if (!label || !variants || iterations == 0) {
+                fprintf(stderr, "Error: bench_run_isa() needs a label, variants and at least one iteration!\n");
+                return -1;
+            }
+
+            int ran = 0;
+            for (int v = 0; v < BENCH_ISA_COUNT; v++) {
+                const bench_isa_variant_t *variant = &variants[v];
+                if (isa_result_count >= MAX_ISA_RESULTS) {
+                    fprintf(stderr, "Error: Exceeded maximum number of ISA results!\n");
+                    return -1;
+                }
+                isa_result_t *r = &isa_results[isa_result_count++];
+                memset(r, 0, sizeof(*r));
+                strncpy(r->label, label, MAX_FUNS_NAME_LENGTH - 1);
+                r->level = variant->fn ? variant->level : (bench_isa_level)v;
+                if (!variant->fn || !bench_isa_supported(variant->level))
+                    continue;
+
+                char variant_label[MAX_FUNS_NAME_LENGTH];
+                snprintf(variant_label, sizeof(variant_label), "%.60s@%s", label, bench_isa_name(variant->level));
+                size_t before = benchmarks.timing_index;
+                if (bench_run_checked(label, variant_label, variant->fn, digest, arg, iterations) != 0)
+                    continue;
+
+                r->ran = 1;
+                if (benchmarks.timing_index > before) {
+                    const time_info *entry = &benchmarks.timings[benchmarks.timing_index - 1];
+                    r->ns_per_call = (double)entry->time_us * 1000.0 / (double)iterations;
+                    r->mismatch    = (entry->flags & BENCH_ENTRY_MISMATCH) != 0;
+                }
+                ran++;
+            }
+            return ran;
+        }
+
+        void print_bench_isa(void) {
+            if (isa_result_count == 0) {
+                fprintf(stdout, "\nNo ISA variant data available.\n");
+                return;
+            }
+
+            fprintf(stdout, "%s-----------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%s| %-20s | %-10s | %-12s | %-8s | %-10s |%s\n", BRIGHT_CYAN,
+                    "Kernel", "ISA", "Time / call", "Speedup", "Output", RESET);
+            fprintf(stdout, "%s-----------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+
+            double baseline = 0.0;
+            for (size_t i = 0; i < isa_result_count; i++) {
+                const isa_result_t *r = &isa_results[i];
+                if (i == 0 || strcmp(r->label, isa_results[i - 1].label) != 0)
+                    baseline = (r->ran && r->level == BENCH_ISA_BASELINE) ? r->ns_per_call : 0.0;
+
+                if (!r->ran) {
+                    fprintf(stdout, "| %-20s | %-10s | %12s | %8s | %-10s |\n",
+                            r->label, bench_isa_name(r->level), "-", "-", "not run");
+                    continue;
+                }
+
+                char time_str[STRING_LENGTH];
+                format_scaled(r->ns_per_call * 1e-9, time_str, STRING_LENGTH, "s");
+                double speedup = (baseline > 0.0 && r->ns_per_call > 0.0) ? baseline / r->ns_per_call : 0.0;
+                const char *color = r->mismatch ? RED : (speedup >= 1.1 ? BRIGHT_GREEN : (speedup > 0.0 && speedup < 0.95 ? BRIGHT_RED : ""));
+                fprintf(stdout, "%s| %-20s | %-10s | %12s | ", color, r->label, bench_isa_name(r->level), time_str);
+                if (speedup > 0.0)
+                    fprintf(stdout, "%7.2fx", speedup);
+                else
+                    fprintf(stdout, "%8s", "-");
+                fprintf(stdout, " | %-10s |%s\n", r->mismatch ? "✗ differs" : "ok", RESET);
+            }
+            fprintf(stdout, "%s-----------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+        }
+
+        // ─── Layout Randomization ─────────────────────────────────────────────────
+
+        /** Continued fraction for the regularized incomplete beta function (modified Lentz). */
+        static double beta_cf(double a, double b, double x) {
+            const double tiny = 1e-300;
+            double c = 1.0, d = 1.0 - (a + b) * x / (a + 1.0);
+            if (fabs(d) < tiny) d = tiny;
+            d = 1.0 / d;
+            double h = d;
+            for (int m = 1; m <= 300; m++) {
+                double m2 = 2.0 * m;
+                double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+                d = 1.0 + aa * d; if (fabs(d) < tiny) d = tiny;
+                c = 1.0 + aa / c; if (fabs(c) < tiny) c = tiny;
+                d = 1.0 / d;
+                h *= d * c;
+                aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+                d = 1.0 + aa * d; if (fabs(d) < tiny) d = tiny;
+                c = 1.0 + aa / c; if (fabs(c) < tiny) c = tiny;
+                d = 1.0 / d;
+                double delta = d * c;
+                h *= delta;
+                if (fabs(delta - 1.0) < 1e-12)
+                    break;
+            }
+            return h;
+        }
+
+        static double incomplete_beta(double a, double b, double x) {
+            if (x <= 0.0) return 0.0;
+            if (x >= 1.0) return 1.0;
+            double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1.0 - x));
+            if (x < (a + 1.0) / (a + b + 2.0))
+                return front * beta_cf(a, b, x) / a;
+            return 1.0 - front * beta_cf(b, a, 1.0 - x) / b;
+        }
+
+        /** One-way ANOVA over a layouts x samples matrix (row-major). */
+        static void layout_decompose(const double *x, size_t layouts, size_t samples, bench_layout_report_t *r) {
+            double grand = 0.0, lo = INFINITY, hi = -INFINITY;
+            double ss_between = 0.0, ss_within = 0.0;
+
+            for (size_t l = 0; l < layouts * samples; l++)
+                grand += x[l];
+            grand /= (double)(layouts * samples);
+
+            for (size_t l = 0; l < layouts; l++) {
+                double m = 0.0;
+                for (size_t k = 0; k < samples; k++)
+                    m += x[l * samples + k];
+                m /= (double)samples;
+                for (size_t k = 0; k < samples; k++)
+                    ss_within += (x[l * samples + k] - m) * (x[l * samples + k] - m);
+                ss_between += (double)samples * (m - grand) * (m - grand);
+                if (m < lo) lo = m;
+                if (m > hi) hi = m;
+            }
+
+            double df1 = (double)(layouts - 1), df2 = (double)(layouts * (samples - 1));
+            double ms_between = ss_between / df1;
+            double ms_within  = ss_within / df2;
+            double var_layout = ms_between > ms_within ? (ms_between - ms_within) / (double)samples : 0.0;
+
+            r->layouts      = layouts;
+            r->samples      = samples;
+            r->mean_ns      = grand;
+            r->layout_cv    = grand > 0.0 ? sqrt(var_layout) / grand : 0.0;
+            r->noise_cv     = grand > 0.0 ? sqrt(ms_within) / grand : 0.0;
+            r->layout_share = (var_layout + ms_within) > 0.0 ? var_layout / (var_layout + ms_within) : 0.0;
+            r->spread       = grand > 0.0 ? (hi - lo) / grand : 0.0;
+            r->f_stat       = ms_within > 0.0 ? ms_between / ms_within : 0.0;
+            r->p_value      = ms_within > 0.0 ? incomplete_beta(df2 / 2.0, df1 / 2.0, df2 / (df2 + df1 * r->f_stat)) : 1.0;
+        }
+
+        __attribute__((noinline))
+        static int64_t layout_sample(bench_layout_fn fn, void *buf, size_t size, void *arg, size_t iterations) {
+            int64_t s = get_time_ns();
+            for (size_t i = 0; i < iterations; i++)
+                fn(buf, size, arg);
+            return get_time_ns() - s;
+        }
+
+        __attribute__((noinline))
+        static int64_t layout_sample_padded(size_t pad, bench_layout_fn fn, void *buf, size_t size, void *arg, size_t iterations) {
+            // The VLA moves every frame below it, like alloca() would.
+            volatile char stack_pad[pad + 1];
+            stack_pad[0] = 0;
+            int64_t ns = layout_sample(fn, buf, size, arg, iterations);
+            stack_pad[pad] = 0;
+            (void)stack_pad;
+            return ns;
+        }
+
+        int bench_run_layout(const char *label, bench_layout_fn fn, void *arg, size_t buf_size,
+                             size_t layouts, size_t samples, size_t iterations, bench_layout_report_t *report) {
+            if (!label || !fn || !report || layouts < 2 || samples < 2 || iterations == 0) {
+                fprintf(stderr, "Error: bench_run_layout() needs a label, a function, a report, "
+                                "at least 2 layouts and 2 samples!\n");
+                return -1;
+            }
+
+            size_t  *pads    = (size_t*)calloc(layouts, sizeof(size_t));
+            void   **blocks  = (void**)calloc(layouts, sizeof(void*));
+            char   **bufs    = (char**)calloc(layouts, sizeof(char*));
+            double  *x       = (double*)calloc(layouts * samples, sizeof(double));
+            size_t   block   = (buf_size + LAYOUT_MAX_HEAP_OFFSET + 4095) & ~(size_t)4095;
+            int      rc      = -1;
+            if (!pads || !blocks || !bufs || !x)
+                goto out;
+
+            for (size_t l = 0; l < layouts; l++) {
+                pads[l] = (size_t)(bench_random() % LAYOUT_MAX_STACK_PAD);
+                if (buf_size == 0)
+                    continue;
+                blocks[l] = aligned_alloc(4096, block);
+                if (!blocks[l])
+                    goto out;
+                memset(blocks[l], 0, block);
+                bufs[l] = (char*)blocks[l] + (bench_random() % (LAYOUT_MAX_HEAP_OFFSET / 8)) * 8;
+            }
+
+            // Round-robin over layouts, so drift over time spreads evenly across them.
+            int64_t total_ns = 0;
+            for (size_t k = 0; k < samples; k++) {
+                for (size_t l = 0; l < layouts; l++) {
+                    int64_t ns = layout_sample_padded(pads[l], fn, bufs[l], buf_size, arg, iterations);
+                    x[l * samples + k] = (double)ns / (double)iterations;
+                    total_ns += ns;
+                }
+            }
+
+            memset(report, 0, sizeof(*report));
+            strncpy(report->label, label, sizeof(report->label) - 1);
+            layout_decompose(x, layouts, samples, report);
+            record_timing_us(label, (long long)llround((double)total_ns / (double)(layouts * samples * iterations) * 1e-3));
+            rc = 0;
+
+        out:
+            if (rc != 0)
+                fprintf(stderr, "Error: Out of memory for the layout experiment!\n");
+            for (size_t l = 0; blocks && l < layouts; l++)
+                free(blocks[l]);
+            free(pads);
+            free(blocks);
+            free(bufs);
+            free(x);
+            return rc;
+        }
+
+        static int64_t layout_exec_once(char *const argv[], char **envp) {
+            int64_t s   = get_time_ns();
+            pid_t   pid = fork();
+            if (pid < 0)
+                return -1;
+            if (pid == 0) {
+                int devnull = open("/dev/null", O_WRONLY);
+                if (devnull >= 0)
+                    dup2(devnull, STDOUT_FILENO);
+                execve(argv[0], argv, envp);
+                _exit(127);
+            }
+            int status = 0;
+            if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                return -1;
+            return get_time_ns() - s;
+        }
+
+        int bench_layout_exec(const char *label, char *const argv[], size_t layouts, size_t samples,
+                              bench_layout_report_t *report) {
+            extern char **environ;
+            if (!label || !argv || !argv[0] || !report || layouts < 2 || samples < 2) {
+                fprintf(stderr, "Error: bench_layout_exec() needs a label, a command, a report, "
+                                "at least 2 layouts and 2 samples!\n");
+                return -1;
+            }
+
+            size_t env_count = 0;
+            while (environ[env_count])
+                env_count++;
+
+            char   **envp = (char**)calloc(env_count + 2, sizeof(char*));
+            char    *pad  = (char*)malloc(sizeof("BENCH_LAYOUT_PAD=") + LAYOUT_MAX_ENV_PAD);
+            size_t  *lens = (size_t*)calloc(layouts, sizeof(size_t));
+            double  *x    = (double*)calloc(layouts * samples, sizeof(double));
+            int      rc   = -1;
+            if (!envp || !pad || !lens || !x) {
+                fprintf(stderr, "Error: Out of memory for the layout experiment!\n");
+                goto out;
+            }
+            memcpy(envp, environ, env_count * sizeof(char*));
+            envp[env_count] = pad;
+            for (size_t l = 0; l < layouts; l++)
+                lens[l] = (size_t)(bench_random() % LAYOUT_MAX_ENV_PAD);
+
+            for (size_t k = 0; k < samples; k++) {
+                for (size_t l = 0; l < layouts; l++) {
+                    int n = snprintf(pad, sizeof("BENCH_LAYOUT_PAD="), "BENCH_LAYOUT_PAD=");
+                    memset(pad + n, 'x', lens[l]);
+                    pad[n + lens[l]] = '\0';
+
+                    int64_t ns = layout_exec_once(argv, envp);
+                    if (ns < 0) {
+                        fprintf(stderr, "Error: Layout run of '%s' failed!\n", argv[0]);
+                        goto out;
+                    }
+                    x[l * samples + k] = (double)ns;
+                }
+            }
+
+            memset(report, 0, sizeof(*report));
+            strncpy(report->label, label, sizeof(report->label) - 1);
+            layout_decompose(x, layouts, samples, report);
+            rc = 0;
+
+        out:
+            free(envp);
+            free(pad);
+            free(lens);
+            free(x);
+            return rc;
+        }
+
+        void print_bench_layout(const bench_layout_report_t *report) {
+            char mean_str[STRING_LENGTH];
+            format_scaled(report->mean_ns * 1e-9, mean_str, STRING_LENGTH, "s");
+            int significant = report->p_value < LAYOUT_ALPHA;
+
+            fprintf(stdout, "%s%s%s", BAR_COLOR, line, RESET);
+            fprintf(stdout, "🧱  %sLayout        %s : %s%s%s (%zu layouts x %zu samples, mean %s)\n",
+                    BRIGHT_CYAN, RESET, BRIGHT_YELLOW, report->label, RESET,
+                    report->layouts, report->samples, mean_str);
+            fprintf(stdout, "📐  %sLayout effect %s : ±%.2f%% (spread %.2f%% between layouts)\n",
+                    BRIGHT_CYAN, RESET, report->layout_cv * 100.0, report->spread * 100.0);
+            fprintf(stdout, "🎲  %sNoise         %s : ±%.2f%% within a layout\n",
+                    BRIGHT_CYAN, RESET, report->noise_cv * 100.0);
+            fprintf(stdout, "📊  %sVariance      %s : %.1f%% from layout (F = %.2f, p = %.3g)  %s%s%s\n",
+                    BRIGHT_CYAN, RESET, report->layout_share * 100.0, report->f_stat, report->p_value,
+                    significant ? BRIGHT_RED : GREEN, significant ? "LAYOUT-SENSITIVE" : "no layout effect", RESET);
+            if (significant)
+                fprintf(stdout, "⚠️   %sSpeedups below %.2f%% may be layout artifacts%s\n",
+                        BRIGHT_YELLOW, report->spread * 100.0, RESET);
+            fprintf(stdout, "%s%s%s\n\n", BAR_COLOR, line, RESET);
+        }
+
+        // ─── Distribution Shape ───────────────────────────────────────────────────
+
+        int bench_shape(const char *label, bench_shape_t *out) {
+            memset(out, 0, sizeof(*out));
+            const bench_samples_t *set = find_samples(label);
+            if (!set || set->count < KDE_MIN_SAMPLES)
+                return -1;
+
+            size_t  n = set->count;
+            double *x = (double*)malloc(n * sizeof(double));
+            double *density = (double*)calloc(2 * KDE_GRID_POINTS, sizeof(double));
+            if (!x || !density) {
+                free(x);
+                free(density);
+                fprintf(stderr, "Error: Out of memory for the density of '%s'!\n", label);
+                return -1;
+            }
+            double *binned = density + KDE_GRID_POINTS;
+
+            double lo = INFINITY, hi = -INFINITY, mean = 0.0, m2 = 0.0;
+            for (size_t i = 0; i < n; i++) {
+                x[i] = log((double)(set->ns[i] > 0 ? set->ns[i] : 1));
+                if (x[i] < lo) lo = x[i];
+                if (x[i] > hi) hi = x[i];
+                double delta = x[i] - mean;
+                mean += delta / (double)(i + 1);
+                m2   += delta * (x[i] - mean);
+            }
+
+            // Silverman's rule on the log scale; the IQR term keeps a far tail from oversmoothing.
+            static const double q[2] = { 0.25, 0.75 };
+            int64_t iq[2] = { 0, 0 };
+            bench_quantiles(set->ns, n, q, 2, iq);
+            double iqr    = log((double)(iq[1] > 0 ? iq[1] : 1)) - log((double)(iq[0] > 0 ? iq[0] : 1));
+            double sd     = sqrt(m2 / (double)(n - 1));
+            double spread = (iqr > 0.0 && iqr / 1.34 < sd) ? iqr / 1.34 : sd;
+            double h      = 0.9 * spread * pow((double)n, -0.2);
+            out->count     = n;
+
+            if (hi <= lo) {
+                out->modes       = 1;
+                out->mode_ns[0]  = exp(lo);
+                out->mode_mass[0] = 1.0;
+                free(x);
+                free(density);
+                return 0;
+            }
+
+            // A tight cluster next to a far tail gives an h below the grid step, which
+            // would turn the KDE into a histogram; keep h at least KDE_MIN_STEPS cells.
+            double step = (hi - lo) / (KDE_GRID_POINTS - 1);
+            if (h < KDE_MIN_STEPS * step)
+                h = KDE_MIN_STEPS * step;
+            out->bandwidth = h;
+
+            // Linear binning onto a grid padded past the extremes, then a truncated Gaussian convolution.
+            double pad = fmax(3.0 * h, 4.0 * step);
+            double g0  = lo - pad, dx = (hi - lo + 2.0 * pad) / (KDE_GRID_POINTS - 1);
+            for (size_t i = 0; i < n; i++) {
+                double pos = (x[i] - g0) / dx;
+                int    j   = (int)pos;
+                double w   = pos - j;
+                binned[j] += 1.0 - w;
+                if (j + 1 < KDE_GRID_POINTS)
+                    binned[j + 1] += w;
+            }
+            int reach = (int)ceil(4.0 * h / dx);
+            for (int g = 0; g < KDE_GRID_POINTS; g++) {
+                if (binned[g] == 0.0)
+                    continue;
+                int a = g - reach < 0 ? 0 : g - reach;
+                int e = g + reach >= KDE_GRID_POINTS ? KDE_GRID_POINTS - 1 : g + reach;
+                for (int k = a; k <= e; k++) {
+                    double u = (k - g) * dx / h;
+                    density[k] += binned[g] * exp(-0.5 * u * u);
+                }
+            }
+
+            double top = 0.0;
+            for (int g = 0; g < KDE_GRID_POINTS; g++)
+                if (density[g] > top) top = density[g];
+
+            // Candidate peaks, then merge neighbours that lack a real valley between them.
+            int peaks[KDE_GRID_POINTS], np = 0;
+            for (int g = 0; g < KDE_GRID_POINTS; g++) {
+                int rises = g == 0 || density[g] > density[g - 1];
+                int falls = g == KDE_GRID_POINTS - 1 || density[g] >= density[g + 1];
+                if (rises && falls && density[g] > 0.0 && density[g] >= KDE_MODE_MIN_HEIGHT * top)
+                    peaks[np++] = g;
+            }
+            int merged = 1;
+            while (merged && np > 1) {
+                merged = 0;
+                for (int p = 0; p + 1 < np; p++) {
+                    double valley = INFINITY;
+                    for (int g = peaks[p]; g <= peaks[p + 1]; g++)
+                        if (density[g] < valley) valley = density[g];
+                    double lower = density[peaks[p]] < density[peaks[p + 1]] ? density[peaks[p]] : density[peaks[p + 1]];
+                    if (valley > KDE_MODE_MAX_DIP * lower) {
+                        int drop = density[peaks[p]] < density[peaks[p + 1]] ? p : p + 1;
+                        memmove(&peaks[drop], &peaks[drop + 1], (size_t)(np - drop - 1) * sizeof(int));
+                        np--;
+                        merged = 1;
+                        break;
+                    }
+                }
+            }
+
+            out->modes = np;
+            double total = 0.0;
+            for (int g = 0; g < KDE_GRID_POINTS; g++)
+                total += density[g];
+            int from = 0;
+            for (int p = 0; p < np && p < BENCH_MAX_MODES; p++) {
+                int to = KDE_GRID_POINTS - 1;
+                if (p + 1 < np) {
+                    to = peaks[p];
+                    for (int g = peaks[p]; g <= peaks[p + 1]; g++)
+                        if (density[g] < density[to]) to = g;
+                }
+                double mass = 0.0;
+                for (int g = from; g <= to; g++)
+                    mass += density[g];
+                out->mode_ns[p]   = exp(g0 + peaks[p] * dx);
+                out->mode_mass[p] = total > 0.0 ? mass / total : 0.0;
+                from = to + 1;
+            }
+
+            free(x);
+            free(density);
+            return 0;
+        }
+
+        /** Asymptotic Kolmogorov distribution tail, with Stephens' small-sample correction. */
+        static double ks_p_value(double d, double n_eff) {
+            double s      = sqrt(n_eff);
+            double lambda = (s + 0.12 + 0.11 / s) * d;
+            if (lambda < 0.2)
+                return 1.0;
+            double sum = 0.0, sign = 1.0;
+            for (int k = 1; k <= 100; k++) {
+                double term = sign * exp(-2.0 * k * k * lambda * lambda);
+                sum += term;
+                if (fabs(term) < 1e-12)
+                    break;
+                sign = -sign;
+            }
+            double p = 2.0 * sum;
+            return p < 0.0 ? 0.0 : (p > 1.0 ? 1.0 : p);
+        }
+
+        int bench_ks_compare(const char *label, const char *baseline, bench_ks_t *out) {
+            memset(out, 0, sizeof(*out));
+            const bench_samples_t *a = find_samples(label);
+            const bench_samples_t *b = find_samples(baseline);
+            if (!a || !b || a->count == 0 || b->count == 0) {
+                fprintf(stderr, "Error: KS comparison needs samples for both '%s' and '%s'!\n", label, baseline);
+                return -1;
+            }
+
+            int64_t *x = (int64_t*)malloc((a->count + b->count) * sizeof(int64_t));
+            if (!x) {
+                fprintf(stderr, "Error: Out of memory for the KS comparison!\n");
+                return -1;
+            }
+            int64_t *y = x + a->count;
+            memcpy(x, a->ns, a->count * sizeof(int64_t));
+            memcpy(y, b->ns, b->count * sizeof(int64_t));
+            if (bench_sort_samples(x, a->count) != 0 || bench_sort_samples(y, b->count) != 0) {
+                free(x);
+                return -1;
+            }
+
+            size_t n = a->count, m = b->count, i = 0, j = 0;
+            while (i < n && j < m) {
+                int64_t v = x[i] < y[j] ? x[i] : y[j];
+                while (i < n && x[i] == v) i++;
+                while (j < m && y[j] == v) j++;
+                double fa = (double)i / (double)n, fb = (double)j / (double)m;
+                if (fabs(fa - fb) > out->d) {
+                    out->d            = fabs(fa - fb);
+                    out->at_ns        = v;
+                    out->cdf_label    = fa;
+                    out->cdf_baseline = fb;
+                }
+            }
+
+            bench_stats_t sa, sb;
+            samples_stats(a, &sa);
+            samples_stats(b, &sb);
+            strncpy(out->label, label, sizeof(out->label) - 1);
+            strncpy(out->baseline, baseline, sizeof(out->baseline) - 1);
+            out->n          = n;
+            out->m          = m;
+            out->p_value    = ks_p_value(out->d, (double)n * (double)m / (double)(n + m));
+            out->mean_shift = sb.mean > 0.0 ? sa.mean / sb.mean - 1.0 : 0.0;
+            free(x);
+            return 0;
+        }
+
+        int bench_samples_save(const char *label, const char *path) {
+            const bench_samples_t *set = find_samples(label);
+            if (!set) {
+                fprintf(stderr, "Error: '%s' keeps no samples!\n", label);
+                return -1;
+            }
+            FILE *f = fopen(path, "w");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open '%s' for writing!\n", path);
+                return -1;
+            }
+            for (size_t i = 0; i < set->count; i++)
+                fprintf(f, "%lld\n", (long long)set->ns[i]);
+            return fclose(f) == 0 ? 0 : -1;
+        }
+
+        long bench_samples_load(const char *label, const char *path) {
+            FILE *f = fopen(path, "r");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open '%s'!\n", path);
+                return -1;
+            }
+            if (bench_keep_samples(label) != 0) {
+                fclose(f);
+                return -1;
+            }
+            bench_samples_t *set = find_samples(label);
+            long long v;
+            long loaded = 0;
+            while (fscanf(f, "%lld", &v) == 1) {
+                samples_append(set, (int64_t)v);
+                loaded++;
+            }
+            fclose(f);
+            return loaded;
+        }
+
+        void print_bench_shape(void) {
+            if (sample_set_count == 0) {
+                fprintf(stdout, "\nNo raw samples retained (shape analysis needs bench_keep_samples() or bench_keep_reservoir()).\n");
+                return;
+            }
+
+            const char *rule = "-----------------------------------------------------------------------------------------------------";
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-20s | %10s | %5s | %-55s |%s\n", BRIGHT_CYAN, "Function", "Samples", "Modes", "Mode latency (share of calls)", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (size_t i = 0; i < sample_set_count; i++) {
+                bench_shape_t shape;
+                if (bench_shape(sample_sets[i].label, &shape) != 0) {
+                    fprintf(stdout, "| %-20s | %10zu | %5s | %-55s |\n", sample_sets[i].label, sample_sets[i].count, "-", "too few samples");
+                    continue;
+                }
+
+                char modes[128] = "", one[48], time_str[STRING_LENGTH];
+                for (int m = 0; m < shape.modes && m < BENCH_MAX_MODES; m++) {
+                    format_scaled(shape.mode_ns[m] * 1e-9, time_str, STRING_LENGTH, "s");
+                    snprintf(one, sizeof(one), "%s%s (%.0f%%)", m ? ", " : "", time_str, shape.mode_mass[m] * 100.0);
+                    strncat(modes, one, sizeof(modes) - strlen(modes) - 1);
+                }
+                const char *color = shape.modes > 1 ? BRIGHT_YELLOW : "";
+                fprintf(stdout, "%s| %-20s | %10zu | %5d | %-55s |%s%s\n", color, sample_sets[i].label, shape.count, shape.modes,
+                        modes, shape.modes > 1 ? " MULTIMODAL" : "", RESET);
+            }
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+        }
+
+        void print_bench_ks(const bench_ks_t *r) {
+            char at_str[STRING_LENGTH];
+            format_scaled((double)r->at_ns * 1e-9, at_str, STRING_LENGTH, "s");
+            int changed = r->p_value < KS_ALPHA;
+
+            fprintf(stdout, "%s%s%s", BAR_COLOR, line, RESET);
+            fprintf(stdout, "📈  %sKS test       %s : %s%s%s vs %s%s%s (%zu vs %zu samples)\n",
+                    BRIGHT_CYAN, RESET, BRIGHT_YELLOW, r->label, RESET, BRIGHT_YELLOW, r->baseline, RESET, r->n, r->m);
+            fprintf(stdout, "📏  %sDistance      %s : D = %.4f at %s (%.1f%% vs %.1f%% of calls at or below), p = %.3g\n",
+                    BRIGHT_CYAN, RESET, r->d, at_str, r->cdf_label * 100.0, r->cdf_baseline * 100.0, r->p_value);
+            fprintf(stdout, "⚖️   %sMean shift    %s : %+.2f%%  %s%s%s\n",
+                    BRIGHT_CYAN, RESET, r->mean_shift * 100.0,
+                    changed ? BRIGHT_RED : GREEN, changed ? "SHAPE CHANGED" : "same distribution", RESET);
+            fprintf(stdout, "%s%s%s\n\n", BAR_COLOR, line, RESET);
+        }
+
+        // ─── cgroup CPU Throttling ────────────────────────────────────────────────
+
+        typedef struct {
+            long long periods;        /**< nr_throttled */
+            long long usec;           /**< throttled_usec (v2) or throttled_time / 1000 (v1) */
+        } cgroup_snapshot_t;
+
+        static struct {
+            int  located;             /**< 1 found, -1 not available, 0 not searched yet */
+            int  version;             /**< 1 or 2 */
+            char mount[256];          /**< Hierarchy mount point */
+            char dir[512];            /**< Our cgroup directory */
+        } cgroup_state;
+
+        static __thread cgroup_snapshot_t cgroup_begin;
+
+        /** Finds the mount of the v2 hierarchy, or of the v1 hierarchy carrying the cpu controller,
+         *  together with the hierarchy path mounted there (mountinfo field 4). */
+        static int cgroup_find_mount(int version, char *mount, char *root, size_t size) {
+            FILE *f = fopen("/proc/self/mountinfo", "r");
+            if (!f)
+                return -1;
+            char line[1024];
+            int  found = -1;
+            while (found < 0 && fgets(line, sizeof(line), f)) {
+                char base[256], point[256], fstype[32], options[512];
+                const char *sep = strstr(line, " - ");
+                if (!sep || sscanf(line, "%*s %*s %*s %255s %255s", base, point) != 2 ||
+                    sscanf(sep + 3, "%31s %*s %511s", fstype, options) != 2)
+                    continue;
+                if (version == 2 && strcmp(fstype, "cgroup2") == 0)
+                    found = 0;
+                if (version == 1 && strcmp(fstype, "cgroup") == 0) {
+                    char *save = NULL;
+                    for (char *tok = strtok_r(options, ",", &save); tok && found < 0; tok = strtok_r(NULL, ",", &save))
+                        if (strcmp(tok, "cpu") == 0)
+                            found = 0;
+                }
+                if (found == 0) {
+                    snprintf(mount, size, "%s", point);
+                    snprintf(root, size, "%s", base);
+                }
+            }
+            fclose(f);
+            return found;
+        }
+
+        /** Path of our cgroup in the v2 hierarchy ("0::/path") or the v1 cpu hierarchy. */
+        static int cgroup_find_path(int version, char *path, size_t size) {
+            FILE *f = fopen("/proc/self/cgroup", "r");
+            if (!f)
+                return -1;
+            char line[1024];
+            int  found = -1;
+            while (found < 0 && fgets(line, sizeof(line), f)) {
+                line[strcspn(line, "\n")] = '\0';
+                char *c1 = strchr(line, ':');
+                char *c2 = c1 ? strchr(c1 + 1, ':') : NULL;
+                if (!c2)
+                    continue;
+                *c2 = '\0';
+                if (version == 2 && strcmp(line, "0") == 0 && c1[1] == '\0')
+                    found = 0;
+                if (version == 1) {
+                    char *save = NULL;
+                    for (char *tok = strtok_r(c1 + 1, ",", &save); tok && found < 0; tok = strtok_r(NULL, ",", &save))
+                        if (strcmp(tok, "cpu") == 0)
+                            found = 0;
+                }
+                if (found == 0)
+                    snprintf(path, size, "%s", c2 + 1);
+            }
+            fclose(f);
+            return found;
+        }
+
+        static int cgroup_read_file(const char *dir, const char *name, char *buf, size_t size) {
+            char path[640];
+            snprintf(path, sizeof(path), "%s/%s", dir, name);
+            int fd = open(path, O_RDONLY);
+            if (fd < 0)
+                return -1;
+            ssize_t n = read(fd, buf, size - 1);
+            close(fd);
+            if (n <= 0)
+                return -1;
+            buf[n] = '\0';
+            return 0;
+        }
+
+        static int cgroup_parse_stat(const char *buf, cgroup_snapshot_t *snap) {
+            const char *p;
+            int found = 0;
+            snap->periods = snap->usec = 0;
+            if ((p = strstr(buf, "nr_throttled ")) != NULL) {
+                snap->periods = strtoll(p + 13, NULL, 10);
+                found++;
+            }
+            if ((p = strstr(buf, "throttled_usec ")) != NULL) {
+                snap->usec = strtoll(p + 15, NULL, 10);
+                found++;
+            } else if ((p = strstr(buf, "throttled_time ")) != NULL) {
+                snap->usec = strtoll(p + 15, NULL, 10) / 1000;
+                found++;
+            }
+            return found == 2 ? 0 : -1;
+        }
+
+        /** Prefers v2; hybrid hosts often keep the cpu controller on v1. */
+        static int cgroup_locate(void) {
+            if (cgroup_state.located)
+                return cgroup_state.located > 0 ? 0 : -1;
+            cgroup_state.located = -1;
+
+            for (int version = 2; version >= 1; version--) {
+                char path[256], root[256], buf[512];
+                cgroup_snapshot_t snap;
+                if (cgroup_find_mount(version, cgroup_state.mount, root, sizeof(cgroup_state.mount)) != 0 ||
+                    cgroup_find_path(version, path, sizeof(path)) != 0)
+                    continue;
+                // A mount may expose only a subtree (containers bind-mount their own cgroup),
+                // so the path from /proc/self/cgroup is relative to that mount's root.
+                const char *rel = path;
+                size_t      len = strlen(root);
+                if (strcmp(root, "/") != 0 && strncmp(path, root, len) == 0 &&
+                    (path[len] == '/' || path[len] == '\0'))
+                    rel = path + len;
+                snprintf(cgroup_state.dir, sizeof(cgroup_state.dir), "%s%s", cgroup_state.mount,
+                         strcmp(rel, "/") == 0 ? "" : rel);
+                if (cgroup_read_file(cgroup_state.dir, "cpu.stat", buf, sizeof(buf)) != 0 ||
+                    cgroup_parse_stat(buf, &snap) != 0)
+                    continue;
+                cgroup_state.version = version;
+                cgroup_state.located = 1;
+                return 0;
+            }
+            return -1;
+        }
+
+        static int cgroup_read(cgroup_snapshot_t *snap) {
+            char buf[512];
+            ssize_t n = pread(cgroup_stat_fd, buf, sizeof(buf) - 1, 0);
+            if (n <= 0)
+                return -1;
+            buf[n] = '\0';
+            return cgroup_parse_stat(buf, snap);
+        }
+
+        static void cgroup_region_begin(void) {
+            if (cgroup_read(&cgroup_begin) != 0)
+                cgroup_begin.periods = -1;
+        }
+
+        static void cgroup_region_end(time_info *entry) {
+            cgroup_snapshot_t end;
+            if (cgroup_begin.periods < 0 || cgroup_read(&end) != 0)
+                return;
+            if (end.periods > cgroup_begin.periods || end.usec > cgroup_begin.usec) {
+                entry->flags           |= BENCH_ENTRY_THROTTLED;
+                entry->throttled_us     = end.usec - cgroup_begin.usec;
+                entry->throttle_periods = (unsigned)(end.periods - cgroup_begin.periods);
+            }
+        }
+
+        int bench_cgroup_enable(int enabled) {
+            if (!enabled) {
+                if (cgroup_stat_fd >= 0)
+                    close(cgroup_stat_fd);
+                cgroup_stat_fd = -1;
+                return 0;
+            }
+            if (cgroup_stat_fd >= 0)
+                return 0;
+            if (cgroup_locate() != 0) {
+                fprintf(stderr, "Warning: No cgroup CPU statistics found, throttling detection disabled!\n");
+                return -1;
+            }
+
+            char path[640];
+            snprintf(path, sizeof(path), "%s/cpu.stat", cgroup_state.dir);
+            cgroup_stat_fd = open(path, O_RDONLY);
+            if (cgroup_stat_fd < 0) {
+                fprintf(stderr, "Warning: Could not open %s!\n", path);
+                return -1;
+            }
+            return 0;
+        }
+
+        double bench_cgroup_cpu_limit(void) {
+            if (cgroup_locate() != 0)
+                return -1.0;
+
+            // Walk up to the hierarchy root: the tightest quota on the path applies.
+            char   dir[512], buf[128];
+            double limit = 0.0;
+            snprintf(dir, sizeof(dir), "%s", cgroup_state.dir);
+            for (;;) {
+                double cpus = 0.0;
+                if (cgroup_state.version == 2) {
+                    long long quota = 0, period = 0;
+                    if (cgroup_read_file(dir, "cpu.max", buf, sizeof(buf)) == 0 &&
+                        sscanf(buf, "%lld %lld", &quota, &period) == 2 && period > 0)
+                        cpus = (double)quota / (double)period;
+                } else {
+                    char qbuf[64];
+                    long long quota = strtoll(cgroup_read_file(dir, "cpu.cfs_quota_us", qbuf, sizeof(qbuf)) == 0 ? qbuf : "-1", NULL, 10);
+                    long long period = strtoll(cgroup_read_file(dir, "cpu.cfs_period_us", buf, sizeof(buf)) == 0 ? buf : "0", NULL, 10);
+                    if (quota > 0 && period > 0)
+                        cpus = (double)quota / (double)period;
+                }
+                if (cpus > 0.0 && (limit == 0.0 || cpus < limit))
+                    limit = cpus;
+
+                char *slash = strrchr(dir, '/');
+                if (strlen(dir) <= strlen(cgroup_state.mount) || !slash)
+                    break;
+                *slash = '\0';
+            }
+            return limit;
+        }
+
+        static void print_cgroup_legend(void) {
+            long long periods = 0;
+            for (size_t i = 0; i < benchmarks.timing_index; i++)
+                periods += benchmarks.timings[i].throttle_periods;
+            double limit = bench_cgroup_cpu_limit();
+            fprintf(stdout, "%sThrottled: time the cgroup CPU quota", BRIGHT_CYAN);
+            if (limit > 0.0)
+                fprintf(stdout, " (%.2f CPUs)", limit);
+            fprintf(stdout, " held the group off-CPU during the region, %lld periods in total%s\n", periods, RESET);
+        }
+
+        // ─── Allocator Suite ──────────────────────────────────────────────────────
+
+        static void *libc_malloc(size_t size, void *ctx)             { (void)ctx; return malloc(size); }
+        static void  libc_free(void *ptr, void *ctx)                 { (void)ctx; free(ptr); }
+        static void *libc_realloc(void *ptr, size_t size, void *ctx) { (void)ctx; return realloc(ptr, size); }
+
+        const bench_allocator_t bench_allocator_libc = { "libc", libc_malloc, libc_free, libc_realloc, NULL };
+
+        static const char *const alloc_pattern_names[BENCH_ALLOC_PATTERN_COUNT] = {
+            "churn", "cross-thread", "size sweep", "realloc growth"
+        };
+
+        typedef struct {
+            char                name[MAX_FUNS_NAME_LENGTH];
+            bench_alloc_pattern pattern;
+            unsigned            threads;
+            double              ops_per_s;
+            int64_t             p50, p99, p999;
+            long long           peak_rss;        /**< High-water mark growth, -1 if unknown */
+            double              overhead;        /**< 1 - live / peak_rss, -1 if unknown */
+        } alloc_result_t;
+
+        static alloc_result_t alloc_results[MAX_ALLOC_RESULTS];
+        static size_t         alloc_result_count;
+
+        static void alloc_results_reset(void) {
+            alloc_result_count = 0;
+        }
+
+        /** Single-producer/single-consumer pointer queue of the cross-thread pattern. */
+        typedef struct {
+            void     *slots[ALLOC_QUEUE_SLOTS];
+            size_t    sizes[ALLOC_QUEUE_SLOTS];
+            // Each index on its own cache line, so the pair does not false-share
+            __attribute__((aligned(64))) size_t    head;     /**< Next slot the consumer reads */
+            __attribute__((aligned(64))) size_t    tail;     /**< Next slot the producer writes */
+            __attribute__((aligned(64))) long long queued;   /**< Bytes allocated but not yet freed */
+        } alloc_queue_t;
+
+        typedef struct {
+            const bench_allocator_t *alloc;
+            bench_alloc_pattern      pattern;
+            size_t                   ops;
+            uint64_t                 rng;
+            alloc_queue_t           *queue;           /**< Cross-thread pattern only */
+            int                      consumer;
+            int                     *start;           /**< 1 = go, -1 = abort */
+            int64_t                 *lat;             /**< Sampled latencies */
+            size_t                   lat_count;
+            long long                live, live_peak; /**< Requested bytes held by this thread */
+        } alloc_worker_t;
+
+        static uint64_t alloc_rand(alloc_worker_t *w) {
+            w->rng ^= w->rng << 13;
+            w->rng ^= w->rng >> 7;
+            w->rng ^= w->rng << 17;
+            return w->rng;
+        }
+
+        static void alloc_track(alloc_worker_t *w, long long delta) {
+            w->live += delta;
+            if (w->live > w->live_peak)
+                w->live_peak = w->live;
+        }
+
+        /** Runs one allocator call, timing every ALLOC_LATENCY_STRIDE-th. */
+        #define ALLOC_TIMED(w, i, call) \
+            do { \
+                if ((i) % ALLOC_LATENCY_STRIDE == 0) { \
+                    int64_t alloc_t0_ = get_time_ns(); \
+                    call; \
+                    (w)->lat[(w)->lat_count++] = get_time_ns() - alloc_t0_; \
+                } else { \
+                    call; \
+                } \
+            } while (0)
+
+        static void alloc_churn(alloc_worker_t *w) {
+            void  *slots[ALLOC_CHURN_SLOTS] = { 0 };
+            size_t sizes[ALLOC_CHURN_SLOTS] = { 0 };
+            for (size_t i = 0; i < w->ops; i++) {
+                size_t k = (size_t)(alloc_rand(w) % ALLOC_CHURN_SLOTS);
+                if (slots[k]) {
+                    ALLOC_TIMED(w, i, w->alloc->free_fn(slots[k], w->alloc->ctx));
+                    alloc_track(w, -(long long)sizes[k]);
+                    slots[k] = NULL;
+                    continue;
+                }
+                sizes[k] = 16 + (size_t)(alloc_rand(w) % 241);
+                ALLOC_TIMED(w, i, slots[k] = w->alloc->malloc_fn(sizes[k], w->alloc->ctx));
+                if (slots[k]) {
+                    memset(slots[k], 0xA5, sizes[k]);
+                    alloc_track(w, (long long)sizes[k]);
+                }
+            }
+            for (size_t k = 0; k < ALLOC_CHURN_SLOTS; k++)
+                if (slots[k])
+                    w->alloc->free_fn(slots[k], w->alloc->ctx);
+        }
+
+        static void alloc_cross_thread(alloc_worker_t *w) {
+            alloc_queue_t *q = w->queue;
+            for (size_t i = 0; i < w->ops; i++) {
+                if (w->consumer) {
+                    size_t head = q->head;
+                    while (__atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == head)
+                        sched_yield();
+                    void  *p    = q->slots[head % ALLOC_QUEUE_SLOTS];
+                    size_t size = q->sizes[head % ALLOC_QUEUE_SLOTS];
+                    ALLOC_TIMED(w, i, w->alloc->free_fn(p, w->alloc->ctx));
+                    __atomic_fetch_sub(&q->queued, (long long)size, __ATOMIC_RELAXED);
+                    __atomic_store_n(&q->head, head + 1, __ATOMIC_RELEASE);
+                } else {
+                    size_t tail = q->tail;
+                    while (tail - __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == ALLOC_QUEUE_SLOTS)
+                        sched_yield();
+                    size_t size = 16 + (size_t)(alloc_rand(w) % 241);
+                    void  *p;
+                    ALLOC_TIMED(w, i, p = w->alloc->malloc_fn(size, w->alloc->ctx));
+                    if (p)
+                        memset(p, 0x5A, size);
+                    // The producer keeps the pair's live peak: bytes in flight through the queue.
+                    long long queued = __atomic_add_fetch(&q->queued, (long long)size, __ATOMIC_RELAXED);
+                    if (queued > w->live_peak)
+                        w->live_peak = queued;
+                    q->slots[tail % ALLOC_QUEUE_SLOTS] = p;
+                    q->sizes[tail % ALLOC_QUEUE_SLOTS] = size;
+                    __atomic_store_n(&q->tail, tail + 1, __ATOMIC_RELEASE);
+                }
+            }
+        }
+
+        static void alloc_size_sweep(alloc_worker_t *w) {
+            enum { batch = 64 };
+            void  *objs[batch];
+            size_t size = 8, i = 0;
+            while (i < w->ops) {
+                size_t n = 0;
+                for (; n < batch && i < w->ops; n++, i++) {
+                    ALLOC_TIMED(w, i, objs[n] = w->alloc->malloc_fn(size, w->alloc->ctx));
+                    if (objs[n])
+                        memset(objs[n], 0xC3, size);
+                }
+                alloc_track(w, (long long)(n * size));
+                for (size_t k = 0; k < n && i < w->ops; k++, i++) {
+                    ALLOC_TIMED(w, i, w->alloc->free_fn(objs[k], w->alloc->ctx));
+                    objs[k] = NULL;
+                }
+                for (size_t k = 0; k < n; k++)
+                    if (objs[k])
+                        w->alloc->free_fn(objs[k], w->alloc->ctx);
+                alloc_track(w, -(long long)(n * size));
+                // Power-of-two classes with a midpoint, so both sides of every class boundary are hit.
+                size = (size & (size - 1)) ? (size & ~(size >> 1)) * 2 : size + size / 2;
+                if (size > 32768)
+                    size = 8;
+            }
+        }
+
+        static void alloc_realloc_growth(alloc_worker_t *w) {
+            void  *p    = NULL;
+            size_t size = 0;
+            for (size_t i = 0; i < w->ops; i++) {
+                size_t next = size ? size + size / 2 : 16;
+                if (next > ALLOC_REALLOC_MAX) {
+                    ALLOC_TIMED(w, i, w->alloc->free_fn(p, w->alloc->ctx));
+                    alloc_track(w, -(long long)size);
+                    p    = NULL;
+                    size = 0;
+                    continue;
+                }
+                void *grown;
+                ALLOC_TIMED(w, i, grown = w->alloc->realloc_fn(p, next, w->alloc->ctx));
+                if (!grown)
+                    break;
+                memset((char*)grown + size, 0x3C, next - size);
+                alloc_track(w, (long long)(next - size));
+                p    = grown;
+                size = next;
+            }
+            if (p)
+                w->alloc->free_fn(p, w->alloc->ctx);
+        }
+
+        static void *alloc_worker_main(void *arg) {
+            alloc_worker_t *w = (alloc_worker_t*)arg;
+            int go;
+            while ((go = __atomic_load_n(w->start, __ATOMIC_ACQUIRE)) == 0)
+                sched_yield();
+            if (go < 0)
+                return NULL;
+            switch (w->pattern) {
+                case BENCH_ALLOC_CHURN:          alloc_churn(w); break;
+                case BENCH_ALLOC_CROSS_THREAD:   alloc_cross_thread(w); break;
+                case BENCH_ALLOC_SIZE_SWEEP:     alloc_size_sweep(w); break;
+                case BENCH_ALLOC_REALLOC_GROWTH: alloc_realloc_growth(w); break;
+                default: break;
+            }
+            return NULL;
+        }
+
+        /** Runs one pattern in the calling (child) process and fills `r`. */
+        static int alloc_measure(const bench_allocator_t *alloc, bench_alloc_pattern pattern,
+                                 unsigned threads, size_t ops, alloc_result_t *r) {
+            alloc_worker_t    *workers = (alloc_worker_t*)calloc(threads, sizeof(alloc_worker_t));
+            pthread_t         *tids    = (pthread_t*)calloc(threads, sizeof(pthread_t));
+            alloc_queue_t     *queues  = NULL;
+            if (pattern == BENCH_ALLOC_CROSS_THREAD &&
+                posix_memalign((void**)&queues, 64, (threads / 2) * sizeof(alloc_queue_t)) == 0)
+                memset(queues, 0, (threads / 2) * sizeof(alloc_queue_t));
+            size_t             per     = ops / ALLOC_LATENCY_STRIDE + 1;
+            int64_t           *lat     = (int64_t*)malloc(threads * per * sizeof(int64_t));
+            int                start   = 0;
+            int                rc      = -1;
+            unsigned           started = 0;
+
+            if (!workers || !tids || !lat || (pattern == BENCH_ALLOC_CROSS_THREAD && !queues)) {
+                fprintf(stderr, "Error: Out of memory for the allocator suite!\n");
+                goto out;
+            }
+            for (unsigned t = 0; t < threads; t++) {
+                alloc_worker_t *w = &workers[t];
+                w->alloc    = alloc;
+                w->pattern  = pattern;
+                w->ops      = ops;
+                w->rng      = 0x9E3779B97F4A7C15ULL * (t + 1);
+                w->queue    = queues ? &queues[t / 2] : NULL;
+                w->consumer = t & 1;
+                w->start    = &start;
+                w->lat      = lat + t * per;
+            }
+
+        #if defined(__GLIBC__)
+            malloc_trim(0);   // drop free heap pages inherited from the parent
+        #endif
+            long long hwm_base = hwm_reset() == 0 ? hwm_read() : -1;
+            for (; started < threads; started++) {
+                if (pthread_create(&tids[started], NULL, alloc_worker_main, &workers[started]) != 0)
+                    break;
+            }
+            if (started < threads) {
+                fprintf(stderr, "Error: Could not start allocator worker threads!\n");
+                __atomic_store_n(&start, -1, __ATOMIC_RELEASE);
+                for (unsigned t = 0; t < started; t++)
+                    pthread_join(tids[t], NULL);
+                goto out;
+            }
+
+            int64_t t0 = get_time_ns();
+            __atomic_store_n(&start, 1, __ATOMIC_RELEASE);
+            for (unsigned t = 0; t < threads; t++)
+                pthread_join(tids[t], NULL);
+            int64_t elapsed = get_time_ns() - t0;
+            long long hwm_end = hwm_base >= 0 ? hwm_read() : -1;
+
+            size_t    lat_count = 0;
+            long long live_peak = 0;
+            for (unsigned t = 0; t < threads; t++) {
+                memmove(lat + lat_count, workers[t].lat, workers[t].lat_count * sizeof(int64_t));
+                lat_count += workers[t].lat_count;
+                live_peak += workers[t].live_peak;
+            }
+
+            static const double q[3] = { 0.50, 0.99, 0.999 };
+            int64_t qv[3] = { 0, 0, 0 };
+            bench_quantiles(lat, lat_count, q, 3, qv);
+
+            r->ops_per_s = elapsed > 0 ? (double)threads * (double)ops * 1e9 / (double)elapsed : 0.0;
+            r->p50       = qv[0];
+            r->p99       = qv[1];
+            r->p999      = qv[2];
+            r->peak_rss  = (hwm_base >= 0 && hwm_end >= 0) ? hwm_end - hwm_base : -1;
+            r->overhead  = r->peak_rss > 0 ? 1.0 - (double)live_peak / (double)r->peak_rss : -1.0;
+            if (r->overhead < 0.0 && r->peak_rss > 0)
+                r->overhead = 0.0;   // the live set fit in memory that was already resident
+            rc = 0;
+
+        out:
+            free(workers);
+            free(tids);
+            free(queues);
+            free(lat);
+            return rc;
+        }
+
+        static int alloc_run_pattern(const bench_allocator_t *alloc, bench_alloc_pattern pattern,
+                                     unsigned threads, size_t ops, alloc_result_t *r) {
+            if (pattern == BENCH_ALLOC_CROSS_THREAD)
+                threads = threads < 2 ? 2 : threads & ~1u;
+
+            memset(r, 0, sizeof(*r));
+            strncpy(r->name, alloc->name ? alloc->name : "?", sizeof(r->name) - 1);
+            r->pattern = pattern;
+            r->threads = threads;
+
+            alloc_result_t *shared = (alloc_result_t*)mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE,
+                                                           MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (shared == MAP_FAILED) {
+                fprintf(stderr, "Error: Could not map the allocator result page!\n");
+                return -1;
+            }
+            *shared = *r;
+
+            fflush(NULL);
+            pid_t pid = fork();
+            if (pid == 0)
+                _exit(alloc_measure(alloc, pattern, threads, ops, shared) == 0 ? 0 : 1);
+
+            int status = 0, rc = -1;
+            if (pid < 0)
+                fprintf(stderr, "Error: Could not fork the allocator run!\n");
+            else if (waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                rc = 0;
+            else
+                fprintf(stderr, "Error: Allocator run '%s' / %s failed in its child process!\n",
+                        r->name, alloc_pattern_names[pattern]);
+            if (rc == 0)
+                *r = *shared;
+            munmap(shared, sizeof(*shared));
+            return rc;
+        }
+
+        int bench_alloc_suite(const bench_allocator_t *alloc, unsigned threads, size_t ops_per_thread) {
+            if (!alloc || !alloc->malloc_fn || !alloc->free_fn || !alloc->realloc_fn || threads == 0 || ops_per_thread == 0) {
+                fprintf(stderr, "Error: bench_alloc_suite() needs a complete allocator table, threads and operations!\n");
+                return -1;
+            }
+
+            for (int p = 0; p < BENCH_ALLOC_PATTERN_COUNT; p++) {
+                if (alloc_result_count >= MAX_ALLOC_RESULTS) {
+                    fprintf(stderr, "Error: Exceeded maximum number of allocator results!\n");
+                    return -1;
+                }
+                if (alloc_run_pattern(alloc, (bench_alloc_pattern)p, threads, ops_per_thread,
+                                      &alloc_results[alloc_result_count]) != 0)
+                    return -1;
+                alloc_result_count++;
+            }
+            return 0;
+        }
+
+        void print_bench_alloc(void) {
+            if (alloc_result_count == 0) {
+                fprintf(stdout, "\nNo allocator data available.\n");
+                return;
+            }
+
+            const char *rule = "-----------------------------------------------------------------------------------------------------------------------";
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%s| %-12s | %-14s | %7s | %12s | %11s | %11s | %11s | %11s | %8s |%s\n", BRIGHT_CYAN,
+                    "Allocator", "Pattern", "Threads", "Ops/s", "p50", "p99", "p99.9", "Peak RSS", "Overhead", RESET);
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+
+            for (size_t i = 0; i < alloc_result_count; i++) {
+                const alloc_result_t *r = &alloc_results[i];
+                char ops[STRING_LENGTH], p50[STRING_LENGTH], p99[STRING_LENGTH], p999[STRING_LENGTH], rss[STRING_LENGTH], over[16];
+                format_scaled(r->ops_per_s, ops, STRING_LENGTH, "op/s");
+                format_scaled((double)r->p50 * 1e-9, p50, STRING_LENGTH, "s");
+                format_scaled((double)r->p99 * 1e-9, p99, STRING_LENGTH, "s");
+                format_scaled((double)r->p999 * 1e-9, p999, STRING_LENGTH, "s");
+                if (r->peak_rss > 0)
+                    format_scaled((double)r->peak_rss, rss, STRING_LENGTH, "B");
+                else
+                    snprintf(rss, sizeof(rss), r->peak_rss == 0 ? "0 B" : "-");
+                if (r->overhead >= 0.0)
+                    snprintf(over, sizeof(over), "%.1f%%", r->overhead * 100.0);
+                else
+                    snprintf(over, sizeof(over), "-");
+                fprintf(stdout, "| %-12s | %-14s | %7u | %12s | %11s | %11s | %11s | %11s | %8s |\n",
+                        r->name, alloc_pattern_names[r->pattern], r->threads, ops, p50, p99, p999, rss, over);
+            }
+            fprintf(stdout, "%s%s%s\n", BRIGHT_CYAN, rule, RESET);
+            fprintf(stdout, "%sLatency: every %dth call timed; Overhead: share of peak RSS growth beyond the live bytes requested%s\n",
+                    BRIGHT_CYAN, ALLOC_LATENCY_STRIDE, RESET);
+        }
+
+        // ─── Clock Skew ───────────────────────────────────────────────────────────
+
+        #define CLOCK_MASK_WORDS  (MAX_CLOCK_CPUS / (8 * sizeof(unsigned long)))
+
+        static struct {
+            int     calibrated;
+            int     ref_cpu;
+            int     count;                         /**< CPUs calibrated besides the reference */
+            int     known[MAX_CLOCK_CPUS];         /**< 1 if the CPU has an offset */
+            int64_t offset_ns[MAX_CLOCK_CPUS];     /**< CPU clock minus reference clock */
+            int64_t bound_ns[MAX_CLOCK_CPUS];      /**< Half the best round trip */
+            int     applied[MAX_CLOCK_CPUS];       /**< 1 if |offset| > bound, so correcting helps */
+        } clock_skew;
+
+        /** Cache line shared by the two ping-pong threads. */
+        typedef struct {
+            __attribute__((aligned(64))) int64_t seq;
+            int64_t remote_ns;
+            int     cpu;
+            int     pinned;                        /**< Remote thread: 1 pinned, -1 failed */
+            unsigned rounds;
+        } clock_line_t;
+
+        static int64_t clock_correct(int64_t ns, int cpu) {
+            if (ns == 0 || cpu < 0 || cpu >= MAX_CLOCK_CPUS || !clock_skew.applied[cpu])
+                return ns;
+            return ns - clock_skew.offset_ns[cpu];
+        }
+
+        /** Pins the calling thread (raw syscalls, so no _GNU_SOURCE is needed). */
+        static int clock_pin(int cpu) {
+        #if defined(__linux__) && defined(SYS_sched_setaffinity)
+            unsigned long mask[CLOCK_MASK_WORDS];
+            memset(mask, 0, sizeof(mask));
+            mask[cpu / (8 * sizeof(unsigned long))] = 1UL << (cpu % (8 * sizeof(unsigned long)));
+            return syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) == 0 ? 0 : -1;
+        #else
+            (void)cpu;
+            return -1;
+        #endif
+        }
+
+        static void *clock_remote_main(void *arg) {
+            clock_line_t *line = (clock_line_t*)arg;
+            int ok = clock_pin(line->cpu) == 0;
+            __atomic_store_n(&line->pinned, ok ? 1 : -1, __ATOMIC_RELEASE);
+            if (!ok)
+                return NULL;
+            for (unsigned r = 0; r < line->rounds; r++) {
+                int64_t want = 2 * (int64_t)r + 1;
+                while (__atomic_load_n(&line->seq, __ATOMIC_ACQUIRE) != want)
+                    ;
+                line->remote_ns = get_time_ns();
+                __atomic_store_n(&line->seq, want + 1, __ATOMIC_RELEASE);
+            }
+            return NULL;
+        }
+
+        int bench_clock_calibrate(unsigned rounds) {
+        #if defined(__linux__) && defined(SYS_sched_getaffinity)
+            unsigned long allowed[CLOCK_MASK_WORDS], original[CLOCK_MASK_WORDS];
+            memset(allowed, 0, sizeof(allowed));
+            if (rounds == 0 || syscall(SYS_sched_getaffinity, 0, sizeof(allowed), allowed) < 0) {
+                fprintf(stderr, "Error: Could not read the CPU affinity mask!\n");
+                return -1;
+            }
+            memcpy(original, allowed, sizeof(original));
+
+            memset(&clock_skew, 0, sizeof(clock_skew));
+            clock_skew.ref_cpu = -1;
+            const size_t bits = 8 * sizeof(unsigned long);
+            for (int cpu = 0; cpu < MAX_CLOCK_CPUS; cpu++) {
+                if (!(allowed[cpu / bits] & (1UL << (cpu % bits))))
+                    continue;
+                if (clock_skew.ref_cpu < 0) {
+                    clock_skew.ref_cpu = cpu;
+                    clock_skew.known[cpu] = 1;
+                    if (clock_pin(cpu) != 0) {
+                        fprintf(stderr, "Error: Could not pin to CPU %d!\n", cpu);
+                        return -1;
+                    }
+                    continue;
+                }
+
+                clock_line_t line;
+                memset(&line, 0, sizeof(line));
+                line.cpu    = cpu;
+                line.rounds = rounds;
+                pthread_t remote;
+                if (pthread_create(&remote, NULL, clock_remote_main, &line) != 0)
+                    break;
+                while (__atomic_load_n(&line.pinned, __ATOMIC_ACQUIRE) == 0)
+                    sched_yield();
+                if (line.pinned < 0) {
+                    pthread_join(remote, NULL);
+                    continue;
+                }
+
+                int64_t best_rtt = INT64_MAX, best_offset = 0;
+                for (unsigned r = 0; r < rounds; r++) {
+                    int64_t t1 = get_time_ns();
+                    __atomic_store_n(&line.seq, 2 * (int64_t)r + 1, __ATOMIC_RELEASE);
+                    while (__atomic_load_n(&line.seq, __ATOMIC_ACQUIRE) != 2 * (int64_t)r + 2)
+                        ;
+                    int64_t t2  = get_time_ns();
+                    int64_t rtt = t2 - t1;
+                    if (rtt < best_rtt) {
+                        best_rtt    = rtt;
+                        best_offset = line.remote_ns - (t1 + t2) / 2;
+                    }
+                }
+                pthread_join(remote, NULL);
+
+                clock_skew.known[cpu]     = 1;
+                clock_skew.offset_ns[cpu] = best_offset;
+                clock_skew.bound_ns[cpu]  = (best_rtt + 1) / 2;
+                // Within the bound the sign of the skew is unknown; shifting would only add noise.
+                clock_skew.applied[cpu]   = llabs(best_offset) > clock_skew.bound_ns[cpu];
+                clock_skew.count++;
+            }
+
+            syscall(SYS_sched_setaffinity, 0, sizeof(original), original);
+            clock_skew.calibrated = 1;
+            return clock_skew.count;
+        #else
+            (void)rounds;
+            fprintf(stderr, "Warning: Clock skew calibration needs Linux CPU affinity!\n");
+            return -1;
+        #endif
+        }
+
+        int64_t bench_clock_offset(int cpu) {
+            if (cpu < 0 || cpu >= MAX_CLOCK_CPUS || !clock_skew.known[cpu])
+                return 0;
+            return clock_skew.offset_ns[cpu];
+        }
+
+        int64_t bench_clock_skew_bound(void) {
+            if (!clock_skew.calibrated)
+                return -1;
+            int64_t bound = 0;
+            for (int cpu = 0; cpu < MAX_CLOCK_CPUS; cpu++) {
+                if (!clock_skew.known[cpu] || cpu == clock_skew.ref_cpu)
+                    continue;
+                int64_t residual = clock_skew.bound_ns[cpu] +
+                                   (clock_skew.applied[cpu] ? 0 : llabs(clock_skew.offset_ns[cpu]));
+                if (residual > bound)
+                    bound = residual;
+            }
+            return bound;
+        }
+
+        static void trace_json_string(FILE *f, const char *s) {
+            fputc('"', f);
+            for (; *s; s++) {
+                if (*s == '"' || *s == '\\')
+                    fputc('\\', f);
+                if ((unsigned char)*s >= 0x20)
+                    fputc(*s, f);
+            }
+            fputc('"', f);
+        }
+
+        int bench_trace_export(const char *path) {
+            FILE *f = fopen(path, "w");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open '%s' for writing!\n", path);
+                return -1;
+            }
+
+            int     n      = span_count < MAX_SPANS ? span_count : MAX_SPANS;
+            int64_t origin = INT64_MAX;
+            for (int i = 0; i < n; i++) {
+                int64_t start = clock_correct(spans[i].start_ns, spans[i].cpu_begin);
+                if (start < origin)
+                    origin = start;
+            }
+
+            int written = 0, inverted = 0;
+            fprintf(f, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+            for (int i = 0; i < n; i++) {
+                const span_record_t *s = &spans[i];
+                if (s->end_ns == 0)
+                    continue;
+                int64_t start = clock_correct(s->start_ns, s->cpu_begin);
+                int64_t end   = clock_correct(s->end_ns, s->cpu_end);
+                if (end < start) {
+                    inverted++;
+                    end = start;
+                }
+                fprintf(f, "%s  {\"name\": ", written ? ",\n" : "");
+                trace_json_string(f, span_labels[s->label]);
+                fprintf(f, ", \"ph\": \"X\", \"pid\": %ld, \"tid\": %ld, \"ts\": %.3f, \"dur\": %.3f, "
+                           "\"args\": {\"cpu_begin\": %d, \"cpu_end\": %d}}",
+                        (long)getpid(), s->tid, (double)(start - origin) / 1000.0, (double)(end - start) / 1000.0,
+                        s->cpu_begin, s->cpu_end);
+                written++;
+            }
+
+            fprintf(f, "\n], \"otherData\": {\"clock\": \"CLOCK_MONOTONIC\", \"clock_skew\": {\"calibrated\": %s",
+                    clock_skew.calibrated ? "true" : "false");
+            if (clock_skew.calibrated) {
+                fprintf(f, ", \"reference_cpu\": %d, \"residual_bound_ns\": %lld, \"cpus\": [",
+                        clock_skew.ref_cpu, (long long)bench_clock_skew_bound());
+                const char *sep = "";
+                for (int cpu = 0; cpu < MAX_CLOCK_CPUS; cpu++) {
+                    if (!clock_skew.known[cpu])
+                        continue;
+                    fprintf(f, "%s{\"cpu\": %d, \"offset_ns\": %lld, \"bound_ns\": %lld, \"applied_offset_ns\": %lld}",
+                            sep, cpu, (long long)clock_skew.offset_ns[cpu], (long long)clock_skew.bound_ns[cpu],
+                            (long long)(clock_skew.applied[cpu] ? clock_skew.offset_ns[cpu] : 0));
+                    sep = ", ";
+                }
+                fprintf(f, "]");
+            }
+            fprintf(f, "}, \"inverted_spans\": %d}}\n", inverted);
+
+            if (fclose(f) != 0)
+                return -1;
+            return written;
+        }
+
+        void print_bench_clock_skew(void) {
+            if (!clock_skew.calibrated) {
+                fprintf(stdout, "\nClock skew not calibrated.\n");
+                return;
+            }
+
+            fprintf(stdout, "%s-----------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%s| %5s | %14s | %14s | %7s |%s\n", BRIGHT_CYAN, "CPU", "Offset", "Bound", "Applied", RESET);
+            fprintf(stdout, "%s-----------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            for (int cpu = 0; cpu < MAX_CLOCK_CPUS; cpu++) {
+                if (!clock_skew.known[cpu])
+                    continue;
+                if (cpu == clock_skew.ref_cpu) {
+                    fprintf(stdout, "| %5d | %14s | %14s | %7s |\n", cpu, "reference", "-", "-");
+                    continue;
+                }
+                if (clock_skew.applied[cpu])
+                    fprintf(stdout, "%s| %5d | %11lld ns | %11lld ns | %7s |%s\n", BRIGHT_YELLOW, cpu,
+                            (long long)clock_skew.offset_ns[cpu], (long long)clock_skew.bound_ns[cpu], "yes", RESET);
+                else
+                    fprintf(stdout, "| %5d | %11lld ns | %11lld ns | %7s |\n", cpu,
+                            (long long)clock_skew.offset_ns[cpu], (long long)clock_skew.bound_ns[cpu], "no");
+            }
+            fprintf(stdout, "%s-----------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%sResidual skew after correction: ≤ %lld ns%s\n", BRIGHT_CYAN, (long long)bench_clock_skew_bound(), RESET);
+        }
+
+        // ─── Auto-tuning & Wisdom ─────────────────────────────────────────────────
+
+        typedef struct {
+            char    fingerprint[17];
+            char    name[MAX_FUNS_NAME_LENGTH];
+            size_t  n;
+            double  ns_per_call;
+            size_t  count;
+            char    params[MAX_TUNE_PARAMS][TUNE_PARAM_NAME_LENGTH];
+            int     values[MAX_TUNE_PARAMS];
+        } wisdom_entry_t;
+
+        typedef struct {
+            char                name[MAX_FUNS_NAME_LENGTH];
+            size_t              n;
+            bench_tune_strategy strategy;
+            size_t              tried;          /**< Configurations measured */
+            size_t              calls;          /**< Kernel calls spent, warm-ups included */
+            char                best[64];       /**< "param=value ..." */
+            double              best_ns;
+            double              default_ns;     /**< 0 if the default was not measured */
+        } tune_result_t;
+
+        static wisdom_entry_t wisdom[MAX_WISDOM_ENTRIES];
+        static size_t         wisdom_count;
+        static unsigned       wisdom_generation;   /**< Bumped on every change, invalidates dispatch caches */
+        static tune_result_t  tune_results[MAX_TUNE_RESULTS];
+        static size_t         tune_result_count;
+
+        static __thread const bench_tune_space_t *dispatch_space;
+        static __thread size_t                    dispatch_n;
+        static __thread unsigned                  dispatch_generation;
+        static __thread int                       dispatch_hit;
+        static __thread bench_tune_config_t       dispatch_cfg;
+
+        static const char *const tune_strategy_names[] = { "grid", "random", "halving" };
+
+        static void tune_results_reset(void) {
+            tune_result_count = 0;
+        }
+
+        const char *bench_machine_fingerprint(void) {
+            static char fingerprint[17];
+            if (fingerprint[0])
+                return fingerprint;
+
+            struct utsname host;
+            char model[128], key[256];
+            if (uname(&host) != 0)
+                memset(&host, 0, sizeof(host));
+            read_cpu_model(model, sizeof(model));
+            snprintf(key, sizeof(key), "%s|%ld|%s|%.2f", model, sysconf(_SC_NPROCESSORS_ONLN),
+                     host.machine, bench_cgroup_cpu_limit());
+
+            uint64_t h = 0xcbf29ce484222325ULL;     // FNV-1a
+            for (const char *c = key; *c; c++)
+                h = (h ^ (unsigned char)*c) * 0x100000001b3ULL;
+            snprintf(fingerprint, sizeof(fingerprint), "%016llx", (unsigned long long)h);
+            return fingerprint;
+        }
+
+        static wisdom_entry_t *find_wisdom(const char *fingerprint, const char *name, size_t n) {
+            for (size_t i = 0; i < wisdom_count; i++)
+                if (wisdom[i].n == n && strcmp(wisdom[i].name, name) == 0 &&
+                    strcmp(wisdom[i].fingerprint, fingerprint) == 0)
+                    return &wisdom[i];
+            if (wisdom_count >= MAX_WISDOM_ENTRIES) {
+                fprintf(stderr, "Error: Exceeded maximum number of wisdom entries!\n");
+                return NULL;
+            }
+            wisdom_entry_t *e = &wisdom[wisdom_count++];
+            memset(e, 0, sizeof(*e));
+            snprintf(e->fingerprint, sizeof(e->fingerprint), "%s", fingerprint);
+            strncpy(e->name, name, MAX_FUNS_NAME_LENGTH - 1);
+            e->n = n;
+            return e;
+        }
+
+        static void tune_decode(const bench_tune_space_t *space, size_t index, bench_tune_config_t *cfg) {
+            memset(cfg, 0, sizeof(*cfg));
+            for (size_t p = 0; p < space->param_count; p++) {
+                cfg->values[p] = space->params[p].values[index % space->params[p].count];
+                index /= space->params[p].count;
+            }
+        }
+
+        static void tune_default(const bench_tune_space_t *space, bench_tune_config_t *cfg) {
+            tune_decode(space, 0, cfg);
+        }
+
+        static void tune_format(const bench_tune_space_t *space, const bench_tune_config_t *cfg, char *out, size_t size) {
+            size_t used = 0;
+            out[0] = '\0';
+            for (size_t p = 0; p < space->param_count && used < size; p++) {
+                int w = snprintf(out + used, size - used, "%s%s=%d", p ? " " : "", space->params[p].name, cfg->values[p]);
+                if (w < 0)
+                    break;
+                used += (size_t)w;
+            }
+        }
+
+        /** Median of `calls` timed calls after one warm-up call. */
+        static int64_t tune_measure(const bench_tune_space_t *space, const bench_tune_config_t *cfg, size_t n,
+                                    int64_t *scratch, size_t calls) {
+            space->fn(cfg, n, space->arg);
+            for (size_t i = 0; i < calls; i++) {
+                int64_t s = get_time_ns();
+                space->fn(cfg, n, space->arg);
+                scratch[i] = get_time_ns() - s;
+            }
+            select_kth(scratch, 0, calls, calls / 2);
+            return scratch[calls / 2];
+        }
+
+        int bench_tune(const bench_tune_space_t *space, size_t n, bench_tune_strategy strategy,
+                       size_t trials, size_t iterations, bench_tune_config_t *best) {
+            if (!space || !space->name || !space->fn || !space->params || space->param_count == 0 ||
+                space->param_count > MAX_TUNE_PARAMS || iterations == 0 ||
+                (unsigned)strategy > BENCH_TUNE_HALVING) {
+                fprintf(stderr, "Error: bench_tune() needs a named space with 1-%d parameters and at least one iteration!\n",
+                        MAX_TUNE_PARAMS);
+                return -1;
+            }
+            if (strpbrk(space->name, " \t\n")) {
+                fprintf(stderr, "Error: Tuning space name '%s' must not contain whitespace!\n", space->name);
+                return -1;
+            }
+
+            size_t total = 1;
+            for (size_t p = 0; p < space->param_count; p++) {
+                const bench_tune_param_t *param = &space->params[p];
+                if (!param->name || !param->values || param->count == 0 ||
+                    strlen(param->name) >= TUNE_PARAM_NAME_LENGTH || strpbrk(param->name, " \t\n=")) {
+                    fprintf(stderr, "Error: Tuning parameter %zu of '%s' needs a short name and at least one value!\n",
+                            p, space->name);
+                    return -1;
+                }
+                if (param->count > MAX_TUNE_CONFIGS / total) {
+                    fprintf(stderr, "Error: Tuning space '%s' has more than %d configurations!\n",
+                            space->name, MAX_TUNE_CONFIGS);
+                    return -1;
+                }
+                total *= param->count;
+            }
+
+            // Candidate configuration indices; index 0 (the default) always comes first
+            size_t k = total;
+            if (strategy == BENCH_TUNE_RANDOM)
+                k = trials ? trials : TUNE_RANDOM_TRIALS;
+            else if (strategy == BENCH_TUNE_HALVING && trials)
+                k = trials;
+            if (k > total)
+                k = total;
+
+            size_t  *candidates = (size_t*)malloc(total * sizeof(size_t));
+            int64_t *scores     = (int64_t*)malloc(k * sizeof(int64_t));
+            int64_t *scratch    = NULL;
+            if (!candidates || !scores) {
+                fprintf(stderr, "Error: Out of memory for %zu tuning candidates!\n", total);
+                free(candidates);
+                free(scores);
+                return -1;
+            }
+            for (size_t i = 0; i < total; i++)
+                candidates[i] = i;
+            for (size_t i = 1; i < k; i++) {
+                size_t j = i + (size_t)(bench_random() % (total - i));
+                size_t t = candidates[i]; candidates[i] = candidates[j]; candidates[j] = t;
+            }
+
+            tune_result_t result;
+            memset(&result, 0, sizeof(result));
+            strncpy(result.name, space->name, MAX_FUNS_NAME_LENGTH - 1);
+            result.n        = n;
+            result.strategy = strategy;
+            result.tried    = k;
+
+            bench_tune_config_t cfg;
+            size_t alive = k, calls = iterations;
+            for (int round = 0; ; round++) {
+                int64_t *grown = (int64_t*)realloc(scratch, calls * sizeof(int64_t));
+                if (!grown) {
+                    fprintf(stderr, "Error: Out of memory for %zu tuning samples!\n", calls);
+                    free(candidates);
+                    free(scores);
+                    free(scratch);
+                    return -1;
+                }
+                scratch = grown;
+
+                for (size_t i = 0; i < alive; i++) {
+                    tune_decode(space, candidates[i], &cfg);
+                    scores[i] = tune_measure(space, &cfg, n, scratch, calls);
+                    if (round == 0 && candidates[i] == 0)
+                        result.default_ns = (double)scores[i];
+                }
+                result.calls += alive * (calls + 1);
+
+                // Order survivors by score (few candidates, so insertion sort)
+                for (size_t i = 1; i < alive; i++) {
+                    int64_t s = scores[i];
+                    size_t  c = candidates[i], j = i;
+                    while (j > 0 && scores[j - 1] > s) {
+                        scores[j]     = scores[j - 1];
+                        candidates[j] = candidates[j - 1];
+                        j--;
+                    }
+                    scores[j]     = s;
+                    candidates[j] = c;
+                }
+
+                if (strategy != BENCH_TUNE_HALVING || alive <= 1)
+                    break;
+                alive = (alive + 1) / 2;
+                calls *= 2;
+            }
+
+            tune_decode(space, candidates[0], &cfg);
+            result.best_ns = (double)scores[0];
+            tune_format(space, &cfg, result.best, sizeof(result.best));
+            if (best)
+                *best = cfg;
+
+            wisdom_entry_t *e = find_wisdom(bench_machine_fingerprint(), space->name, n);
+            if (e) {
+                e->ns_per_call = result.best_ns;
+                e->count       = space->param_count;
+                for (size_t p = 0; p < space->param_count; p++) {
+                    snprintf(e->params[p], TUNE_PARAM_NAME_LENGTH, "%s", space->params[p].name);
+                    e->values[p] = cfg.values[p];
+                }
+                wisdom_generation++;
+            }
+
+            if (tune_result_count < MAX_TUNE_RESULTS)
+                tune_results[tune_result_count++] = result;
+            else
+                fprintf(stderr, "Error: Exceeded maximum number of tuning results!\n");
+
+            free(candidates);
+            free(scores);
+            free(scratch);
+            return (int)k;
+        }
+
+        /** Maps a wisdom entry onto a space; fails if a parameter is missing or its value is no longer allowed. */
+        static int wisdom_apply(const wisdom_entry_t *e, const bench_tune_space_t *space, bench_tune_config_t *cfg) {
+            for (size_t p = 0; p < space->param_count; p++) {
+                const bench_tune_param_t *param = &space->params[p];
+                size_t q = 0;
+                while (q < e->count && strcmp(e->params[q], param->name) != 0)
+                    q++;
+                if (q == e->count)
+                    return -1;
+                size_t v = 0;
+                while (v < param->count && param->values[v] != e->values[q])
+                    v++;
+                if (v == param->count)
+                    return -1;
+                cfg->values[p] = e->values[q];
+            }
+            return 0;
+        }
+
+        int bench_tune_lookup(const bench_tune_space_t *space, size_t n, bench_tune_config_t *cfg) {
+            if (!space || !cfg || !space->name || space->param_count > MAX_TUNE_PARAMS)
+                return -1;
+            tune_default(space, cfg);
+
+            const char *fingerprint = bench_machine_fingerprint();
+            const wisdom_entry_t *nearest = NULL;
+            double best_distance = INFINITY;
+            for (size_t i = 0; i < wisdom_count; i++) {
+                const wisdom_entry_t *e = &wisdom[i];
+                if (strcmp(e->name, space->name) != 0 || strcmp(e->fingerprint, fingerprint) != 0)
+                    continue;
+                bench_tune_config_t probe;
+                if (wisdom_apply(e, space, &probe) != 0)
+                    continue;
+                double distance = fabs(log((double)(e->n + 1) / (double)(n + 1)));
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    nearest       = e;
+                }
+            }
+            if (!nearest)
+                return -1;
+            return wisdom_apply(nearest, space, cfg);
+        }
+
+        int bench_tune_dispatch(const bench_tune_space_t *space, size_t n) {
+            if (!space || !space->fn)
+                return -1;
+            if (space != dispatch_space || n != dispatch_n || dispatch_generation != wisdom_generation) {
+                dispatch_hit        = bench_tune_lookup(space, n, &dispatch_cfg);
+                dispatch_space      = space;
+                dispatch_n          = n;
+                dispatch_generation = wisdom_generation;
+            }
+            space->fn(&dispatch_cfg, n, space->arg);
+            return dispatch_hit;
+        }
+
+        int bench_wisdom_load(const char *path) {
+            FILE *f = fopen(path, "r");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open wisdom file '%s'!\n", path);
+                return -1;
+            }
+
+            const char *ours = bench_machine_fingerprint();
+            char line[1024];
+            int  loaded = 0;
+            while (fgets(line, sizeof(line), f)) {
+                if (line[0] == '#' || line[0] == '\n')
+                    continue;
+
+                char fingerprint[17], name[MAX_FUNS_NAME_LENGTH];
+                unsigned long long n;
+                double ns;
+                int used = 0;
+                if (sscanf(line, "%16s %99s %llu %lf%n", fingerprint, name, &n, &ns, &used) != 4) {
+                    fprintf(stderr, "Warning: Skipping malformed wisdom line in '%s'!\n", path);
+                    continue;
+                }
+
+                wisdom_entry_t parsed;
+                memset(&parsed, 0, sizeof(parsed));
+                char *save = NULL;
+                for (char *tok = strtok_r(line + used, " \t\n", &save); tok && parsed.count < MAX_TUNE_PARAMS;
+                     tok = strtok_r(NULL, " \t\n", &save)) {
+                    char *eq = strchr(tok, '=');
+                    if (!eq || eq == tok || (size_t)(eq - tok) >= TUNE_PARAM_NAME_LENGTH)
+                        continue;
+                    memcpy(parsed.params[parsed.count], tok, (size_t)(eq - tok));
+                    parsed.values[parsed.count++] = atoi(eq + 1);
+                }
+
+                wisdom_entry_t *e = find_wisdom(fingerprint, name, (size_t)n);
+                if (!e)
+                    break;
+                e->ns_per_call = ns;
+                e->count       = parsed.count;
+                memcpy(e->params, parsed.params, sizeof(e->params));
+                memcpy(e->values, parsed.values, sizeof(e->values));
+                if (strcmp(fingerprint, ours) == 0)
+                    loaded++;
+            }
+            fclose(f);
+            wisdom_generation++;
+            return loaded;
+        }
+
+        int bench_wisdom_save(const char *path) {
+            FILE *f = fopen(path, "w");
+            if (!f) {
+                fprintf(stderr, "Error: Could not open '%s' for writing!\n", path);
+                return -1;
+            }
+
+            fprintf(f, "# bench.h wisdom: fingerprint name size ns_per_call param=value...\n");
+            for (size_t i = 0; i < wisdom_count; i++) {
+                const wisdom_entry_t *e = &wisdom[i];
+                fprintf(f, "%s %s %zu %.1f", e->fingerprint, e->name, e->n, e->ns_per_call);
+                for (size_t p = 0; p < e->count; p++)
+                    fprintf(f, " %s=%d", e->params[p], e->values[p]);
+                fputc('\n', f);
+            }
+            if (fclose(f) != 0)
+                return -1;
+            return (int)wisdom_count;
+        }
+
+        void print_bench_tune(void) {
+            if (tune_result_count == 0) {
+                fprintf(stdout, "\nNo tuning data available.\n");
+                return;
+            }
+
+            fprintf(stdout, "%s---------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%s| %-16s | %8s | %-8s | %6s | %7s | %-24s | %10s | %7s |%s\n", BRIGHT_CYAN,
+                    "Space", "Size", "Strategy", "Tried", "Calls", "Best", "Time/call", "vs def", RESET);
+            fprintf(stdout, "%s---------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            for (size_t i = 0; i < tune_result_count; i++) {
+                const tune_result_t *r = &tune_results[i];
+                char time_str[STRING_LENGTH];
+                format_scaled(r->best_ns * 1e-9, time_str, STRING_LENGTH, "s");
+                double speedup = (r->default_ns > 0.0 && r->best_ns > 0.0) ? r->default_ns / r->best_ns : 0.0;
+                fprintf(stdout, "%s| %-16s | %8zu | %-8s | %6zu | %7zu | %-24.24s | %10s | ",
+                        speedup >= 1.1 ? BRIGHT_GREEN : "", r->name, r->n, tune_strategy_names[r->strategy],
+                        r->tried, r->calls, r->best, time_str);
+                if (speedup > 0.0)
+                    fprintf(stdout, speedup < 100.0 ? "%6.2fx" : "%6.0fx", speedup);
+                else
+                    fprintf(stdout, "%7s", "-");
+                fprintf(stdout, " |%s\n", RESET);
+            }
+            fprintf(stdout, "%s---------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%sWisdom: %zu entries, machine %s%s\n", BRIGHT_CYAN, wisdom_count, bench_machine_fingerprint(), RESET);
+        }
+
+        // ─── Cold Page Cache I/O ──────────────────────────────────────────────────
+
+        typedef struct {
+            char   label[MAX_FUNS_NAME_LENGTH];
+            size_t bytes;                  /**< Bytes moved per call */
+            size_t iterations;
+            double cold_ns;                /**< Mean per call */
+            double warm_ns;
+            double residency;              /**< Worst page-cache residency seen right after an eviction */
+        } io_result_t;
+
+        static char        cold_files[MAX_COLD_FILES][MAX_COLD_PATH];
+        static size_t      cold_file_count;
+        static io_result_t io_results[MAX_IO_RESULTS];
+        static size_t      io_result_count;
+
+        static void io_results_reset(void) {
+            io_result_count = 0;
+        }
+
+        double bench_page_residency(const char *path) {
+            int fd = open(path, O_RDONLY);
+            if (fd < 0)
+                return -1.0;
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                return -1.0;
+            }
+            if (st.st_size == 0) {
+                close(fd);
+                return 0.0;
+            }
+
+            size_t page  = (size_t)sysconf(_SC_PAGESIZE);
+            size_t pages = ((size_t)st.st_size + page - 1) / page;
+            void  *map   = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED)
+                return -1.0;
+
+            unsigned char *vec = (unsigned char*)malloc(pages);
+            double fraction = -1.0;
+            if (vec && mincore(map, (size_t)st.st_size, vec) == 0) {
+                size_t resident = 0;
+                for (size_t i = 0; i < pages; i++)
+                    resident += vec[i] & 1;
+                fraction = (double)resident / (double)pages;
+            }
+            free(vec);
+            munmap(map, (size_t)st.st_size);
+            return fraction;
+        }
+
+        /** fsync() then POSIX_FADV_DONTNEED; fsync first because dirty pages cannot be dropped. */
+        static int cold_evict(const char *path) {
+        #if defined(POSIX_FADV_DONTNEED)
+            int fd = open(path, O_RDONLY);
+            if (fd < 0)
+                return -1;
+            fsync(fd);
+            int rc = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+            return rc == 0 ? 0 : -1;
+        #else
+            (void)path;
+            return -1;
+        #endif
+        }
+
+        static void cold_evict_all(void) {
+            for (size_t i = 0; i < cold_file_count; i++)
+                cold_evict(cold_files[i]);
+        }
+
+        int bench_cold_file(const char *path) {
+            if (!path) {
+                cold_file_count = 0;
+                return 0;
+            }
+            if (cold_file_count >= MAX_COLD_FILES) {
+                fprintf(stderr, "Error: Exceeded maximum number of cold files!\n");
+                return -1;
+            }
+            if (strlen(path) >= MAX_COLD_PATH || cold_evict(path) != 0) {
+                fprintf(stderr, "Error: Could not evict '%s' from the page cache!\n", path);
+                return -1;
+            }
+            snprintf(cold_files[cold_file_count++], MAX_COLD_PATH, "%s", path);
+            return 0;
+        }
+
+        /** Times `iterations` calls under `label`, evicting `path` before each one when `cold`. */
+        static int64_t io_pass(const char *label, const char *path, bench_fn fn, void *arg,
+                               size_t iterations, int cold, double *residency) {
+            bench_samples_t *samples = find_samples(label);
+            if (cgroup_stat_fd >= 0)
+                cgroup_region_begin();
+
+            int64_t total_ns = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                if (cold) {
+                    cold_evict(path);
+                    cold_evict_all();
+                    double r = bench_page_residency(path);
+                    if (r > *residency)
+                        *residency = r;
+                }
+                int64_t s = get_time_ns();
+                fn(arg);
+                int64_t d = get_time_ns() - s;
+                total_ns += d;
+                if (samples)
+                    samples_append(samples, d);
+            }
+
+            time_info *entry = record_entry(label, (long long)(total_ns / 1000));
+            if (entry && cgroup_stat_fd >= 0)
+                cgroup_region_end(entry);
+            return total_ns;
+        }
+
+        int bench_run_io(const char *label, const char *path, bench_fn fn, void *arg,
+                         size_t bytes, size_t iterations) {
+            if (!label || !path || !fn || iterations == 0) {
+                fprintf(stderr, "Error: bench_run_io() needs a label, a file, a function and at least one iteration!\n");
+                return -1;
+            }
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                fprintf(stderr, "Error: Could not stat '%s'!\n", path);
+                return -1;
+            }
+            if (cold_evict(path) != 0) {
+                fprintf(stderr, "Error: Could not evict '%s' from the page cache!\n", path);
+                return -1;
+            }
+            if (io_result_count >= MAX_IO_RESULTS) {
+                fprintf(stderr, "Error: Exceeded maximum number of I/O results!\n");
+                return -1;
+            }
+
+            io_result_t *r = &io_results[io_result_count++];
+            memset(r, 0, sizeof(*r));
+            strncpy(r->label, label, MAX_FUNS_NAME_LENGTH - 1);
+            r->bytes      = bytes ? bytes : (size_t)st.st_size;
+            r->iterations = iterations;
+
+            char mode_label[MAX_FUNS_NAME_LENGTH];
+            snprintf(mode_label, sizeof(mode_label), "%.90s@cold", label);
+            r->cold_ns = (double)io_pass(mode_label, path, fn, arg, iterations, 1, &r->residency) / (double)iterations;
+
+            fn(arg);    // fill the page cache
+            snprintf(mode_label, sizeof(mode_label), "%.90s@warm", label);
+            r->warm_ns = (double)io_pass(mode_label, path, fn, arg, iterations, 0, &r->residency) / (double)iterations;
+
+            if (r->residency > 0.01)
+                fprintf(stderr, "Warning: %.1f%% of '%s' stayed cached after eviction (mapped, locked or on tmpfs?)\n",
+                        r->residency * 100.0, path);
+            return 0;
+        }
+
+        void print_bench_io(void) {
+            if (io_result_count == 0) {
+                fprintf(stdout, "\nNo I/O data available.\n");
+                return;
+            }
+
+            fprintf(stdout, "%s-----------------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            fprintf(stdout, "%s| %-20s | %10s | %12s | %12s | %12s | %12s | %9s | %7s |%s\n", BRIGHT_CYAN,
+                    "I/O", "Size", "Cold / call", "Cold", "Warm / call", "Warm", "Cold/Warm", "Evicted", RESET);
+            fprintf(stdout, "%s-----------------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
+            for (size_t i = 0; i < io_result_count; i++) {
+                const io_result_t *r = &io_results[i];
+                char size_str[STRING_LENGTH], cold_str[STRING_LENGTH], warm_str[STRING_LENGTH];
+                char cold_rate[STRING_LENGTH], warm_rate[STRING_LENGTH];
+                format_scaled((double)r->bytes, size_str, STRING_LENGTH, "B");
+                format_scaled(r->cold_ns * 1e-9, cold_str, STRING_LENGTH, "s");
+                format_scaled(r->warm_ns * 1e-9, warm_str, STRING_LENGTH, "s");
+                format_scaled(r->cold_ns > 0.0 ? (double)r->bytes / (r->cold_ns * 1e-9) : 0.0, cold_rate, STRING_LENGTH, "B/s");
+                format_scaled(r->warm_ns > 0.0 ? (double)r->bytes / (r->warm_ns * 1e-9) : 0.0, warm_rate, STRING_LENGTH, "B/s");
+                double ratio = r->warm_ns > 0.0 ? r->cold_ns / r->warm_ns : 0.0;
+                fprintf(stdout, "%s| %-20s | %10s | %12s | %12s | %12s | %12s | %8.2fx | %6.1f%% |%s\n",
+                        r->residency > 0.01 ? BRIGHT_YELLOW : "", r->label, size_str, cold_str, cold_rate,
+                        warm_str, warm_rate, ratio, (1.0 - r->residency) * 100.0, RESET);
             }
+            fprintf(stdout, "%s-----------------------------------------------------------------------------------------------------------------------%s\n", BRIGHT_CYAN, RESET);
         }
 
         #endif // BENCH_IMPLEMENTATION
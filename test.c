@@ -1,7 +1,8 @@
 /*
  * test.c - Example usage of the bench.h single-header benchmark library
  * 
- * Compile with: gcc -o test test.c -lm -lrt
+ * Compile with: gcc -o test test.c -lm -lrt -pthread
+ * OpenMP tracing: add -fopenmp -DBENCH_OMPT and link an OMPT runtime (e.g. LLVM libomp)
  * Run with: ./test
  */
 
@@ -9,6 +10,12 @@
 #include "bench.h"
 
 #include <unistd.h>  // for usleep()
+#include <pthread.h>
+#include <fcntl.h>   // for open()
+
+#if defined(_OPENMP)
+    #include <omp.h>
+#endif
 
 // Example functions to benchmark
 void fast_operation(void) {
@@ -72,8 +79,339 @@ void fft_simulation(void) {
     }
 }
 
+// Adapter for the runner-style APIs, which pass a user context
+void fast_operation_body(void *arg) {
+    (void)arg;
+    fast_operation();
+}
+
+// Kernel variants for output validation
+#define KERNEL_SIZE 4096
+
+typedef struct {
+    double in[KERNEL_SIZE];
+    double out[KERNEL_SIZE];
+} kernel_ctx;
+
+void scale_scalar(void *arg) {
+    kernel_ctx *k = (kernel_ctx*)arg;
+    for (int i = 0; i < KERNEL_SIZE; i++)
+        k->out[i] = k->in[i] * 2.0;
+}
+
+void scale_unrolled(void *arg) {
+    kernel_ctx *k = (kernel_ctx*)arg;
+    for (int i = 0; i < KERNEL_SIZE; i += 4) {
+        k->out[i]     = k->in[i]     * 2.0;
+        k->out[i + 1] = k->in[i + 1] * 2.0;
+        k->out[i + 2] = k->in[i + 2] * 2.0;
+        k->out[i + 3] = k->in[i + 3] * 2.0;
+    }
+}
+
+void scale_broken(void *arg) {
+    kernel_ctx *k = (kernel_ctx*)arg;
+    for (int i = 0; i < KERNEL_SIZE - 1; i++)
+        k->out[i] = k->in[i] * 2.0;
+    k->out[KERNEL_SIZE - 1] = 0.0;   // "fast" because it skips work
+}
+
+void scale_digest(void *arg, bench_digest_t *out) {
+    kernel_ctx *k = (kernel_ctx*)arg;
+    bench_digest_f64(k->out, KERNEL_SIZE, out);
+}
+
+// Same kernel compiled for every x86-64 level
+BENCH_ISA_KERNEL(scale_isa, arg,
+    kernel_ctx *k = (kernel_ctx*)arg;
+    for (int i = 0; i < KERNEL_SIZE; i++)
+        k->out[i] = k->in[i] * 2.0 + 1.0;
+);
+
+// Layout randomization: a buffer sum whose speed depends on alignment
+void sum_buffer(void *buf, size_t size, void *arg) {
+    const uint32_t *v = (const uint32_t*)buf;
+    uint32_t *sum = (uint32_t*)arg;
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++)
+        *sum += v[i];
+}
+
+// Busy-wait, so durations do not depend on the scheduler
+void spin_us(int64_t us) {
+    int64_t until = get_time_ns() + us * 1000;
+    while (get_time_ns() < until)
+        ;
+}
+
+// Distribution shape: v2 sends every 20th call down a slow path at about the same mean
+void lookup_v1(void *arg) {
+    (void)arg;
+    spin_us(20);
+}
+
+void lookup_v2(void *arg) {
+    static int calls;
+    (void)arg;
+    spin_us(++calls % 20 == 0 ? 80 : 17);
+}
+
+// Allocator suite: libc behind one global lock, like a naive pool allocator
+static pthread_mutex_t locked_heap = PTHREAD_MUTEX_INITIALIZER;
+
+void *locked_malloc(size_t size, void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&locked_heap);
+    void *p = malloc(size);
+    pthread_mutex_unlock(&locked_heap);
+    return p;
+}
+
+void locked_free(void *ptr, void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&locked_heap);
+    free(ptr);
+    pthread_mutex_unlock(&locked_heap);
+}
+
+void *locked_realloc(void *ptr, size_t size, void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&locked_heap);
+    void *p = realloc(ptr, size);
+    pthread_mutex_unlock(&locked_heap);
+    return p;
+}
+
+// Auto-tuning: blocked matrix transpose, block size and loop order tunable
+#define TUNE_MAX_N 512
+
+double tune_src[TUNE_MAX_N * TUNE_MAX_N];
+double tune_dst[TUNE_MAX_N * TUNE_MAX_N];
+
+void transpose_tuned(const bench_tune_config_t *cfg, size_t n, void *arg) {
+    (void)arg;
+    size_t block = (size_t)cfg->values[0];
+    int    by_column = cfg->values[1];
+    for (size_t ib = 0; ib < n; ib += block)
+        for (size_t jb = 0; jb < n; jb += block)
+            for (size_t i = ib; i < ib + block && i < n; i++)
+                for (size_t j = jb; j < jb + block && j < n; j++) {
+                    if (by_column)
+                        tune_dst[i * n + j] = tune_src[j * n + i];
+                    else
+                        tune_dst[j * n + i] = tune_src[i * n + j];
+                }
+}
+
+static const int tune_blocks[] = { 1, 8, 16, 32, 64 };
+static const int tune_orders[] = { 0, 1 };
+static const bench_tune_param_t tune_params[] = {
+    { "block", tune_blocks, 5 },
+    { "by_column", tune_orders, 2 },
+};
+static const bench_tune_space_t transpose_space = { "transpose", tune_params, 2, transpose_tuned, NULL };
+
+// Cold page cache: read a whole file in 1 MiB chunks
+#define IO_FILE_SIZE (16 << 20)
+
+void read_file(void *arg) {
+    static char chunk[1 << 20];
+    int fd = open((const char*)arg, O_RDONLY);
+    if (fd < 0)
+        return;
+    while (read(fd, chunk, sizeof(chunk)) > 0)
+        ;
+    close(fd);
+}
+
+// Fork-join team with deliberately uneven partitioning
+#define TEAM_SIZE 4
+
+typedef struct {
+    bench_par_t       *region;
+    pthread_barrier_t *barrier;
+    int                thread;
+} team_arg;
+
+void *team_worker(void *arg) {
+    team_arg *a = (team_arg*)arg;
+    bench_par_work_begin(a->region, a->thread);
+    usleep(500 * (a->thread + 1));   // thread t gets (t + 1) chunks
+    bench_par_work_end(a->region, a->thread);
+    bench_par_wait_begin(a->region, a->thread);
+    pthread_barrier_wait(a->barrier);
+    bench_par_wait_end(a->region, a->thread);
+    return NULL;
+}
+
+// Corpus replay: checksum each record of a generated corpus
+void checksum_record(const unsigned char *data, size_t size, void *arg) {
+    unsigned *sum = (unsigned*)arg;
+    for (size_t i = 0; i < size; i++)
+        *sum = *sum * 31 + data[i];
+}
+
+// Writes `count` length-prefixed records of 16 B .. 16 KiB to `path`
+int write_corpus(const char *path, int count) {
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return -1;
+    unsigned char payload[16384];
+    memset(payload, 0xab, sizeof(payload));
+    for (int i = 0; i < count; i++) {
+        uint32_t size = 16u << (bench_random() % 11);
+        unsigned char prefix[4] = { size & 0xff, (size >> 8) & 0xff, (size >> 16) & 0xff, size >> 24 };
+        fwrite(prefix, 1, 4, f);
+        fwrite(payload, 1, size, f);
+    }
+    return fclose(f);
+}
+
+// Causal profiling: a two-stage pipeline where stage_b dominates
+void process_item(void) {
+    bench_span_t a = bench_span_begin("stage_a");
+    spin_us(100);
+    bench_span_end(a);
+    bench_span_t b = bench_span_begin("stage_b");
+    spin_us(300);
+    bench_span_end(b);
+    BENCH_PROGRESS("item");
+}
+
+// The same stages split over a producer and a consumer thread joined by a bounded queue
+#define PIPE_DEPTH 4
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    int             queued;
+    int             done;
+} pipe_queue = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 };
+
+void *pipe_producer(void *arg) {
+    int64_t until = *(int64_t*)arg;
+    while (get_time_ns() < until) {
+        bench_span_t a = bench_span_begin("stage_a");
+        spin_us(100);
+        bench_span_end(a);
+        pthread_mutex_lock(&pipe_queue.lock);
+        while (pipe_queue.queued == PIPE_DEPTH)
+            pthread_cond_wait(&pipe_queue.changed, &pipe_queue.lock);
+        pipe_queue.queued++;
+        pthread_cond_broadcast(&pipe_queue.changed);
+        pthread_mutex_unlock(&pipe_queue.lock);
+    }
+    pthread_mutex_lock(&pipe_queue.lock);
+    pipe_queue.done = 1;
+    pthread_cond_broadcast(&pipe_queue.changed);
+    pthread_mutex_unlock(&pipe_queue.lock);
+    return NULL;
+}
+
+void *pipe_consumer(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&pipe_queue.lock);
+        while (pipe_queue.queued == 0 && !pipe_queue.done)
+            pthread_cond_wait(&pipe_queue.changed, &pipe_queue.lock);
+        if (pipe_queue.queued == 0) {
+            pthread_mutex_unlock(&pipe_queue.lock);
+            return NULL;
+        }
+        pipe_queue.queued--;
+        pthread_cond_broadcast(&pipe_queue.changed);
+        pthread_mutex_unlock(&pipe_queue.lock);
+        bench_span_t b = bench_span_begin("stage_b");
+        spin_us(300);
+        bench_span_end(b);
+        BENCH_PROGRESS("item");
+    }
+}
+
+// Self-benchmark: cost of the library's own hot paths
+#define SELF_BATCH   500   // recordings per batch, below MAX_FUNS_TO_BENCH
+#define SELF_ROUNDS  100
+#define SELF_THREADS 4
+
+static char self_labels[SELF_BATCH][16];
+
+void self_report(const char *what, int64_t ns, long ops) {
+    printf("  %-40s %8.1f ns\n", what, (double)ns / (double)ops);
+}
+
+int64_t self_start_end(int keep_samples) {
+    int64_t total = 0;
+    for (int r = 0; r < SELF_ROUNDS; r++) {
+        benchmark_init();
+        if (keep_samples)
+            bench_keep_samples("self_region");   // benchmark_init() drops sample sets
+        int64_t t0 = get_time_ns();
+        for (int i = 0; i < SELF_BATCH; i++) {
+            START_TIMING();
+            END_TIMING("self_region");
+        }
+        total += get_time_ns() - t0;
+    }
+    return total;
+}
+
+int64_t self_record_timing(int unique) {
+    int64_t total = 0;
+    for (int r = 0; r < SELF_ROUNDS; r++) {
+        benchmark_init();
+        int64_t t0 = get_time_ns();
+        for (int i = 0; i < SELF_BATCH; i++)
+            record_timing(unique ? self_labels[i] : "self_region");
+        total += get_time_ns() - t0;
+    }
+    return total;
+}
+
+typedef struct {
+    pthread_barrier_t *start;
+    int64_t            ns;
+    int                pairs;
+} self_thread_arg;
+
+void *self_thread(void *arg) {
+    self_thread_arg *a = (self_thread_arg*)arg;
+    pthread_barrier_wait(a->start);
+    int64_t t0 = get_time_ns();
+    for (int i = 0; i < a->pairs; i++) {
+        START_TIMING();
+        END_TIMING("self_region");
+    }
+    a->ns += get_time_ns() - t0;
+    return NULL;
+}
+
+// ns per START/END pair and thread when `nthreads` threads record at once
+double self_scaling(int nthreads) {
+    self_thread_arg   args[SELF_THREADS];
+    pthread_t         threads[SELF_THREADS];
+    pthread_barrier_t start;
+    long              ops = 0;
+    int64_t           ns  = 0;
+
+    for (int t = 0; t < nthreads; t++)
+        args[t] = (self_thread_arg){ &start, 0, SELF_BATCH / nthreads };
+    for (int r = 0; r < SELF_ROUNDS; r++) {
+        benchmark_init();
+        pthread_barrier_init(&start, NULL, nthreads);
+        for (int t = 0; t < nthreads; t++)
+            pthread_create(&threads[t], NULL, self_thread, &args[t]);
+        for (int t = 0; t < nthreads; t++)
+            pthread_join(threads[t], NULL);
+        pthread_barrier_destroy(&start);
+        ops += (long)nthreads * (SELF_BATCH / nthreads);
+    }
+    for (int t = 0; t < nthreads; t++)
+        ns += args[t].ns;
+    return (double)ns / (double)ops;
+}
+
 int main(void) {
     LOG("Starting benchmark utility test");
+    int failures = 0;
     
     // Initialize the benchmark system
     benchmark_init();
@@ -198,6 +536,351 @@ int main(void) {
     }
     END_TIMING("medium_op_100x");
     
+    // Test 8: Soak mode (short run; real soaks last hours)
+    printf("\n%s[TEST 8]%s Soak Mode\n", BRIGHT_GREEN, RESET);
+    
+    bench_soak_report_t soak;
+    bench_soak("fast_op_soak", fast_operation_body, NULL, 0.5, &soak);
+    print_bench_soak(&soak);
+    
+    // Test 9: Per-region memory footprint
+    printf("\n%s[TEST 9]%s Memory Footprint\n", BRIGHT_GREEN, RESET);
+    
+    bench_mem_enable(1, 1);
+    
+    START_TIMING();
+    memory_intensive_operation();
+    END_TIMING("memory_footprint");
+    
+    bench_mem_enable(0, 0);
+    
+    // Test 10: Output validation across variants
+    printf("\n%s[TEST 10]%s Output Validation\n", BRIGHT_GREEN, RESET);
+    
+    static kernel_ctx kernel;
+    for (int i = 0; i < KERNEL_SIZE; i++)
+        kernel.in[i] = (double)(i % 97) * 0.5;
+    
+    bench_keep_samples("scale_scalar");
+    bench_keep_reservoir("scale_unrolled", 64);
+    
+    bench_run_checked("scale", "scale_scalar", scale_scalar, scale_digest, &kernel, 100);
+    bench_run_checked("scale", "scale_unrolled", scale_unrolled, scale_digest, &kernel, 100);
+    bench_run_checked("scale", "scale_broken", scale_broken, scale_digest, &kernel, 100);
+    
+    // Test 11: Statistics over retained raw samples
+    printf("\n%s[TEST 11]%s Sample Statistics\n", BRIGHT_GREEN, RESET);
+    
+    print_bench_samples();
+    bench_ranked_sparklines(1);
+    
+    // A kept set turned into a reservoir must keep sampling uniformly: 1000 old, 100000 new
+    bench_keep_samples("converted");
+    for (int i = 0; i < 1000; i++)
+        bench_record_sample("converted", i);
+    bench_keep_reservoir("converted", 256);
+    for (int i = 0; i < 100000; i++)
+        bench_record_sample("converted", 1000 + i);
+    const bench_samples_t *converted = bench_get_samples("converted");
+    size_t replaced = 0;
+    for (size_t i = 0; i < converted->count; i++)
+        replaced += converted->ns[i] >= 1000;
+    int reservoir_ok = converted->seen == 101000 && converted->count == 256 && replaced >= 240 &&
+                       fabs(converted->mean - 50499.5) < 1e-6 && converted->min == 0 && converted->max == 100999;
+    printf("Reservoir conversion: %zu seen, %zu of %zu from later calls  %s\n",
+           converted->seen, replaced, converted->count, reservoir_ok ? "ok" : "FAILED");
+    if (!reservoir_ok)
+        failures++;
+    
+    // Shuffled -5000..4999: nearest-rank quantiles and the sorted order are known exactly
+    static int64_t known[10000];
+    for (int i = 0; i < 10000; i++)
+        known[i] = i - 5000;
+    for (int i = 9999; i > 0; i--) {
+        int     j = (int)(bench_random() % (uint64_t)(i + 1));
+        int64_t t = known[i]; known[i] = known[j]; known[j] = t;
+    }
+    const double few_q[5]  = { 0.0, 0.5, 0.99, 0.999, 1.0 };
+    const int64_t few_e[5] = { -5000, -1, 4899, 4989, 4999 };
+    double  deciles[11];
+    int64_t few[5], by_sort[11];
+    for (int i = 0; i <= 10; i++)
+        deciles[i] = i / 10.0;
+    int quantiles_ok = bench_quantiles(known, 10000, few_q, 5, few) == 0 &&
+                       bench_quantiles(known, 10000, deciles, 11, by_sort) == 0;
+    for (int i = 0; i < 5 && quantiles_ok; i++)
+        quantiles_ok = few[i] == few_e[i];
+    for (int i = 0; i <= 10 && quantiles_ok; i++)
+        quantiles_ok = by_sort[i] == (i == 0 ? -5000 : i * 1000 - 5001);
+    int sort_ok = bench_sort_samples(known, 10000) == 0;
+    for (int i = 0; i < 10000 && sort_ok; i++)
+        sort_ok = known[i] == i - 5000;
+    printf("Quantiles (selection and sort paths): %s, radix sort: %s\n",
+           quantiles_ok ? "ok" : "FAILED", sort_ok ? "ok" : "FAILED");
+    if (!quantiles_ok || !sort_ok)
+        failures++;
+    
+    // Test 12: Critical path over a small task graph
+    printf("\n%s[TEST 12]%s Critical Path\n", BRIGHT_GREEN, RESET);
+    
+    for (int frame = 0; frame < 3; frame++) {
+        bench_span_t load = bench_span_begin("load");
+        usleep(2000);
+        bench_span_end(load);
+        
+        bench_span_t decode_a = bench_span_begin("decode_audio");
+        usleep(1000);
+        bench_span_end(decode_a);
+        bench_span_depends(decode_a, load);
+        
+        bench_span_t decode_v = bench_span_begin("decode_video");
+        usleep(3000);
+        bench_span_end(decode_v);
+        bench_span_depends(decode_v, load);
+        
+        bench_span_t mux = bench_span_begin("mux");
+        usleep(500);
+        bench_span_end(mux);
+        bench_span_depends(mux, decode_a);
+        bench_span_depends(mux, decode_v);
+    }
+    print_bench_critical_path();
+    
+    // Test 13: Load imbalance in a parallel region
+    printf("\n%s[TEST 13]%s Parallel Load Imbalance\n", BRIGHT_GREEN, RESET);
+    
+    for (int run = 0; run < 5; run++) {
+        pthread_t         threads[TEAM_SIZE];
+        team_arg          args[TEAM_SIZE];
+        pthread_barrier_t barrier;
+        pthread_barrier_init(&barrier, NULL, TEAM_SIZE);
+        
+        bench_par_t *region = bench_par_begin("uneven_loop", TEAM_SIZE);
+        for (int t = 0; t < TEAM_SIZE; t++) {
+            args[t] = (team_arg){ region, &barrier, t };
+            pthread_create(&threads[t], NULL, team_worker, &args[t]);
+        }
+        for (int t = 0; t < TEAM_SIZE; t++)
+            pthread_join(threads[t], NULL);
+        bench_par_end(region);
+        
+        pthread_barrier_destroy(&barrier);
+    }
+    print_bench_parallel();
+    
+#if defined(_OPENMP)
+    // Test 14: OpenMP constructs traced through OMPT, no annotations
+    printf("\n%s[TEST 14]%s OpenMP Regions\n", BRIGHT_GREEN, RESET);
+    
+    for (int run = 0; run < 3; run++) {
+        #pragma omp parallel for schedule(static) num_threads(4)
+        for (int i = 0; i < 16; i++)
+            usleep(200 * (i / 4 + 1));   // later chunks are heavier
+    }
+    printf("OMPT tool: %s\n", bench_ompt_active() ? "attached" : "not attached");
+    print_bench_parallel();
+#endif
+    
+    // Test 15: Top-down breakdown of a region (needs PMU access)
+    printf("\n%s[TEST 15]%s Top-down Analysis\n", BRIGHT_GREEN, RESET);
+    
+    if (bench_tma_enable(1) == 0) {
+        printf("Counters: %s\n", bench_tma_source());
+        START_TIMING();
+        fft_simulation();
+        END_TIMING("fft_topdown");
+        bench_tma_enable(0);
+    }
+    
+    // Test 16: Replay a memory-mapped corpus
+    printf("\n%s[TEST 16]%s Corpus Replay\n", BRIGHT_GREEN, RESET);
+    
+    char corpus_path[] = "/tmp/bench_corpus_XXXXXX";
+    int  corpus_fd     = mkstemp(corpus_path);
+    bench_corpus_t corpus;
+    if (corpus_fd >= 0 && write_corpus(corpus_path, 2000) == 0 &&
+        bench_corpus_open(&corpus, corpus_path, BENCH_CORPUS_SHUFFLE | BENCH_CORPUS_PREFAULT) == 0) {
+        unsigned sum = 0;
+        printf("Corpus: %zu records, %zu bytes\n", corpus.count, corpus.bytes);
+        bench_run_corpus("checksum_replay", checksum_record, &sum, &corpus, 10000);
+        print_bench_corpus();
+        bench_corpus_close(&corpus);
+    }
+    if (corpus_fd >= 0) {
+        close(corpus_fd);
+        unlink(corpus_path);
+    }
+    
+    printf("\n%s[TEST 17]%s Causal Profiling\n", BRIGHT_GREEN, RESET);
+    
+    if (bench_causal_start("item", 10) == 0) {
+        int64_t causal_until = get_time_ns() + 800 * 1000000LL;
+        while (get_time_ns() < causal_until)
+            process_item();
+        bench_causal_stop();
+        print_bench_causal();
+    }
+    
+    // Two threads: a speedup of one stage is charged as delay to the other running thread
+    if (bench_causal_start("item", 10) == 0) {
+        int64_t   pipe_until = get_time_ns() + 800 * 1000000LL;
+        pthread_t producer, consumer;
+        pthread_create(&consumer, NULL, pipe_consumer, NULL);
+        pthread_create(&producer, NULL, pipe_producer, &pipe_until);
+        pthread_join(producer, NULL);
+        pthread_join(consumer, NULL);
+        bench_causal_stop();
+        printf("Pipeline (producer: stage_a, consumer: stage_b):\n");
+        print_bench_causal();
+    }
+    
+    printf("\n%s[TEST 18]%s Reference Normalization\n", BRIGHT_GREEN, RESET);
+    
+    bench_normalize("medium_op_100x", BENCH_REF_FP);
+    bench_normalize("fft_1024_simulation", BENCH_REF_FP);
+    bench_normalize("memory_intensive", BENCH_REF_BANDWIDTH);
+    bench_normalize("checksum_replay", BENCH_REF_INT);
+    print_bench_env();
+    
+    printf("\n%s[TEST 19]%s ISA Variants\n", BRIGHT_GREEN, RESET);
+    
+    bench_run_isa("scale_isa", scale_isa, scale_digest, &kernel, 1000);
+    print_bench_isa();
+    
+    printf("\n%s[TEST 20]%s Layout Randomization\n", BRIGHT_GREEN, RESET);
+    
+    bench_layout_report_t layout;
+    uint32_t layout_sum = 0;
+    if (bench_run_layout("sum_buffer", sum_buffer, &layout_sum, 64 * 1024, 10, 5, 50, &layout) == 0)
+        print_bench_layout(&layout);
+    
+    char *true_argv[] = { "/bin/true", NULL };
+    if (bench_layout_exec("/bin/true", true_argv, 5, 4, &layout) == 0)
+        print_bench_layout(&layout);
+    
+    printf("\n%s[TEST 21]%s Distribution Shape\n", BRIGHT_GREEN, RESET);
+    
+    char baseline_path[] = "/tmp/bench_baseline_XXXXXX";
+    int  baseline_fd     = mkstemp(baseline_path);
+    bench_keep_samples("lookup_v1");
+    bench_keep_samples("lookup_v2");
+    bench_run("lookup_v1", lookup_v1, NULL, 2000);
+    bench_run("lookup_v2", lookup_v2, NULL, 2000);
+    if (baseline_fd >= 0 && bench_samples_save("lookup_v1", baseline_path) == 0 &&
+        bench_samples_load("lookup_v1@saved", baseline_path) > 0) {
+        bench_ks_t ks;
+        if (bench_ks_compare("lookup_v2", "lookup_v1@saved", &ks) == 0)
+            print_bench_ks(&ks);
+    }
+    if (baseline_fd >= 0) {
+        close(baseline_fd);
+        unlink(baseline_path);
+    }
+    print_bench_shape();
+    
+    // Known mixture: 95% at 17 µs, 5% slow path at 80 µs, ±50 ns jitter
+    bench_keep_samples("bimodal");
+    for (int i = 0; i < 2000; i++)
+        bench_record_sample("bimodal", (i % 20 == 0 ? 80000 : 17000) + (int64_t)(bench_random() % 101) - 50);
+    bench_shape_t bimodal;
+    int shape_ok = bench_shape("bimodal", &bimodal) == 0 && bimodal.modes == 2 &&
+                   fabs(bimodal.mode_mass[0] - 0.95) < 0.01 && fabs(bimodal.mode_mass[1] - 0.05) < 0.01;
+    printf("Bimodal check: %d modes, %.1f%% / %.1f%%  %s\n", bimodal.modes,
+           bimodal.mode_mass[0] * 100.0, bimodal.mode_mass[1] * 100.0, shape_ok ? "ok" : "FAILED");
+    if (!shape_ok)
+        failures++;
+    
+    printf("\n%s[TEST 22]%s cgroup CPU Throttling\n", BRIGHT_GREEN, RESET);
+    
+    if (bench_cgroup_enable(1) == 0) {
+        double limit = bench_cgroup_cpu_limit();
+        if (limit > 0.0)
+            printf("CPU quota: %.2f CPUs\n", limit);
+        else
+            printf("CPU quota: none\n");
+        START_TIMING();
+        medium_operation();
+        END_TIMING("quota_region");   // gets a Throttled column entry if the quota bit
+        bench_cgroup_enable(0);
+    }
+    
+    printf("\n%s[TEST 23]%s Allocator Suite\n", BRIGHT_GREEN, RESET);
+    
+    const bench_allocator_t locked = { "locked libc", locked_malloc, locked_free, locked_realloc, NULL };
+    for (unsigned threads = 1; threads <= 2; threads++) {
+        bench_alloc_suite(&bench_allocator_libc, threads, 20000);
+        bench_alloc_suite(&locked, threads, 20000);
+    }
+    print_bench_alloc();
+    
+    // Test 24: Cross-core clock skew and corrected trace export
+    printf("\n%s[TEST 24]%s Clock Skew & Trace Export\n", BRIGHT_GREEN, RESET);
+    
+    int skew_cpus = bench_clock_calibrate(2000);
+    print_bench_clock_skew();
+    char trace_path[] = "/tmp/bench_traceXXXXXX";
+    int  trace_fd     = mkstemp(trace_path);
+    if (skew_cpus >= 0 && trace_fd >= 0) {
+        close(trace_fd);
+        int events = bench_trace_export(trace_path);
+        printf("Exported %d spans (skew-corrected)\n", events);
+        unlink(trace_path);
+    }
+    
+    // Test 25: Auto-tuning with persisted wisdom
+    printf("\n%s[TEST 25]%s Auto-tuning & Wisdom\n", BRIGHT_GREEN, RESET);
+    
+    bench_tune(&transpose_space, 128, BENCH_TUNE_GRID, 0, 5, NULL);
+    bench_tune(&transpose_space, 512, BENCH_TUNE_RANDOM, 6, 3, NULL);
+    bench_tune(&transpose_space, 512, BENCH_TUNE_HALVING, 0, 2, NULL);
+    print_bench_tune();
+    
+    char wisdom_path[] = "/tmp/bench_wisdomXXXXXX";
+    int  wisdom_fd     = mkstemp(wisdom_path);
+    if (wisdom_fd >= 0) {
+        close(wisdom_fd);
+        bench_wisdom_save(wisdom_path);
+        printf("Reloaded %d wisdom entries for this machine\n", bench_wisdom_load(wisdom_path));
+        unlink(wisdom_path);
+    }
+    bench_tune_config_t tuned;
+    int hit = bench_tune_lookup(&transpose_space, 300, &tuned);
+    printf("Dispatch n=300: %s block=%d by_column=%d\n", hit == 0 ? "wisdom" : "default",
+           tuned.values[0], tuned.values[1]);
+    bench_tune_dispatch(&transpose_space, 300);
+    
+    // Test 26: Cold vs warm page cache
+    printf("\n%s[TEST 26]%s Cold Page Cache I/O\n", BRIGHT_GREEN, RESET);
+    
+    char io_path[] = "/tmp/bench_ioXXXXXX";
+    int  io_fd     = mkstemp(io_path);
+    if (io_fd >= 0) {
+        static char io_block[1 << 20];
+        memset(io_block, 'x', sizeof(io_block));
+        for (int i = 0; i < IO_FILE_SIZE / (int)sizeof(io_block); i++)
+            if (write(io_fd, io_block, sizeof(io_block)) < 0)
+                break;
+        close(io_fd);
+        bench_run_io("read_file", io_path, read_file, io_path, 0, 3);
+        print_bench_io();
+        unlink(io_path);
+    }
+    
+    // Test 27: Mirror regions into the kernel trace (needs write access to trace_marker)
+    printf("\n%s[TEST 27]%s Kernel Trace Markers\n", BRIGHT_GREEN, RESET);
+    
+    if (bench_ftrace_enable(1) == 0) {
+        for (int i = 0; i < 3; i++) {
+            START_TIMING();
+            fast_operation();
+            END_TIMING("traced_region");
+        }
+        bench_ftrace_enable(0);
+        printf("Markers written; the overhead is reported under the ranked table\n");
+    } else {
+        printf("trace_marker not writable, markers skipped\n");
+    }
+    
     printf("\n%s" "═══════════════════════════════════════════════════════════════" "%s\n", 
            BRIGHT_CYAN, RESET);
     printf("%s" "                        FINAL RESULTS                          " "%s\n", 
@@ -207,8 +890,67 @@ int main(void) {
     
     print_bench_ranked();
     
+    // Self-benchmark: runs last because it resets the recorded results
+    printf("\n%s[SELF-BENCHMARK]%s Instrumentation Overhead\n", BRIGHT_GREEN, RESET);
+    
+    const long self_ops = (long)SELF_ROUNDS * SELF_BATCH;
+    for (int i = 0; i < SELF_BATCH; i++)
+        snprintf(self_labels[i], sizeof(self_labels[i]), "label_%d", i);
+    
+    self_report("START_TIMING/END_TIMING pair", self_start_end(0), self_ops);
+    self_report("record_timing, repeated label", self_record_timing(0), self_ops);
+    self_report("record_timing, unique labels", self_record_timing(1), self_ops);
+    self_report("START/END pair, raw samples kept", self_start_end(1), self_ops);
+    
+    // Log macros into /dev/null: LOG goes to buffered stdout, WARN/ERROR to unbuffered stderr
+    fflush(stdout);
+    int saved_out = dup(STDOUT_FILENO), saved_err = dup(STDERR_FILENO);
+    int devnull   = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    dup2(devnull, STDERR_FILENO);
+    int64_t log_ns[3];
+    int64_t t0 = get_time_ns();
+    for (long i = 0; i < self_ops; i++) LOG("self %ld", i);
+    fflush(stdout);
+    log_ns[0] = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (long i = 0; i < self_ops; i++) WARN("self %ld", i);
+    log_ns[1] = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (long i = 0; i < self_ops; i++) ERROR("self %ld", i);
+    log_ns[2] = get_time_ns() - t0;
+    dup2(saved_out, STDOUT_FILENO);
+    dup2(saved_err, STDERR_FILENO);
+    close(devnull);
+    close(saved_out);
+    close(saved_err);
+    self_report("LOG (stdout, buffered)", log_ns[0], self_ops);
+    self_report("WARN (stderr, unbuffered)", log_ns[1], self_ops);
+    self_report("ERROR (stderr, unbuffered)", log_ns[2], self_ops);
+    
+    bench_keep_samples("self_append");
+    t0 = get_time_ns();
+    for (long i = 0; i < self_ops; i++) bench_record_sample("self_append", i);
+    self_report("bench_record_sample, keep all", get_time_ns() - t0, self_ops);
+    bench_keep_reservoir("self_reservoir", 1024);
+    t0 = get_time_ns();
+    for (long i = 0; i < self_ops; i++) bench_record_sample("self_reservoir", i);
+    self_report("bench_record_sample, reservoir of 1024", get_time_ns() - t0, self_ops);
+    const bench_samples_t *appended = bench_get_samples("self_append");
+    uint64_t bins[64] = {0};
+    t0 = get_time_ns();
+    bench_histogram(appended->ns, appended->count, 0, self_ops, 64, bins);
+    self_report("bench_histogram, per sample", get_time_ns() - t0, (long)appended->count);
+    
+    printf("  START/END pair with concurrent recording threads:\n");
+    double one_thread = self_scaling(1);
+    for (int n = 1; n <= SELF_THREADS; n *= 2) {
+        double ns = n == 1 ? one_thread : self_scaling(n);
+        printf("    %d thread%s %8.1f ns per pair and thread (%.2fx)\n", n, n == 1 ? ": " : "s:", ns, ns / one_thread);
+    }
+    
     printf("\n%s✅ Benchmark utility test completed successfully!%s\n\n", 
            BRIGHT_GREEN, RESET);
     
-    return 0;
+    return failures ? 1 : 0;
 }
\ No newline at end of file